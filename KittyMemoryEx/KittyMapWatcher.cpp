@@ -0,0 +1,87 @@
+#include "KittyMapWatcher.hpp"
+
+using KittyMemoryEx::ProcMapEntry;
+
+// both entries map the same thing at the same addresses, only protection may differ
+static inline bool sameMapping(const ProcMapEntry &a, const ProcMapEntry &b)
+{
+    if (a.pathname != b.pathname || a.inode != b.inode || a.devMajor != b.devMajor || a.devMinor != b.devMinor ||
+        a.is_shared != b.is_shared)
+        return false;
+
+    // file offsets must line up with addresses
+    return !a.inode || (a.offset - b.offset) == (a.startAddress - b.startAddress);
+}
+
+/**
+ * Check if entry is covered by the same mapping in other, other is sorted & cursor only moves forward
+ *
+ * @param protectionChanged: set if a covering entry has a different protection
+ * @param oldProtection: protection of the first covering entry with a different protection
+ */
+static bool coveredBySame(const ProcMapEntry &entry, const std::vector<ProcMapEntry> &other, size_t &cursor,
+                          bool &protectionChanged, int &oldProtection)
+{
+    while (cursor < other.size() && other[cursor].endAddress <= entry.startAddress)
+        cursor++;
+
+    protectionChanged = false;
+
+    uintptr_t covered = entry.startAddress;
+    for (size_t j = cursor; j < other.size() && other[j].startAddress < entry.endAddress; j++)
+    {
+        const ProcMapEntry &o = other[j];
+        if (o.startAddress > covered || !sameMapping(entry, o))
+            return false;
+
+        if (j == cursor || (!protectionChanged && o.protection != entry.protection))
+            oldProtection = o.protection;
+
+        if (o.protection != entry.protection)
+            protectionChanged = true;
+
+        covered = o.endAddress;
+    }
+
+    return covered >= entry.endAddress;
+}
+
+bool KittyMapWatcher::poll(std::vector<KittyMapChange> &changes)
+{
+    changes.clear();
+
+    if (_pid <= 0)
+        return false;
+
+    // nothing changed, skip parsing
+    if (!KittyMemoryEx::readMapsFile(_pid, _nextRaw) || _nextRaw == _raw)
+        return false;
+
+    _raw.swap(_nextRaw);
+
+    // pathname ids stay the same between refreshes of the same table
+    _prev = _table.entries();
+    _table.refresh(_raw);
+
+    const auto &curr = _table.entries();
+    bool protectionChanged = false;
+    int oldProtection = 0;
+
+    size_t cursor = 0;
+    for (auto &it : _prev)
+    {
+        if (!coveredBySame(it, curr, cursor, protectionChanged, oldProtection))
+            changes.emplace_back(EK_MAP_REMOVED, _table.toProcMap(it));
+    }
+
+    cursor = 0;
+    for (auto &it : curr)
+    {
+        if (!coveredBySame(it, _prev, cursor, protectionChanged, oldProtection))
+            changes.emplace_back(EK_MAP_ADDED, _table.toProcMap(it));
+        else if (protectionChanged)
+            changes.emplace_back(EK_MAP_PROTECTION_CHANGED, _table.toProcMap(it), oldProtection);
+    }
+
+    return !changes.empty();
+}
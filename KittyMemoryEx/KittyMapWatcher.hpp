@@ -0,0 +1,56 @@
+#pragma once
+
+#include "KittyUtils.hpp"
+#include "KittyMemoryEx.hpp"
+
+enum EKittyMapEvent
+{
+    EK_MAP_ADDED = 0,
+    EK_MAP_REMOVED,
+    EK_MAP_PROTECTION_CHANGED
+};
+
+struct KittyMapChange
+{
+    EKittyMapEvent event;
+    KittyMemoryEx::ProcMap map;
+    // protection before the change, for EK_MAP_PROTECTION_CHANGED
+    int oldProtection;
+
+    KittyMapChange() : event(EK_MAP_ADDED), oldProtection(0) {}
+    KittyMapChange(EKittyMapEvent event, const KittyMemoryEx::ProcMap &map, int oldProtection = 0)
+        : event(event), map(map), oldProtection(oldProtection) {}
+};
+
+/**
+ * Keeps the last maps of a process and reports what changed on each poll.
+ *
+ * Raw maps content is compared to the previous poll first so an unchanged process costs one read & a memcmp.
+ * Maps split or merged without changing what they map (e.g. mprotect of part of a map)
+ * are reported as protection changes of the new ranges, not as remove & add.
+ */
+class KittyMapWatcher
+{
+private:
+    pid_t _pid;
+    std::string _raw, _nextRaw;
+    KittyMemoryEx::ProcMapTable _table;
+    std::vector<KittyMemoryEx::ProcMapEntry> _prev;
+
+public:
+    KittyMapWatcher() : _pid(0) {}
+    explicit KittyMapWatcher(pid_t pid) : _pid(pid), _table(pid) {}
+
+    inline pid_t pid() const { return _pid; }
+
+    /**
+     * Maps as of the last poll
+     */
+    inline const KittyMemoryEx::ProcMapTable &table() const { return _table; }
+
+    /**
+     * Reread maps & fill changes since last poll, removed maps come first then added & changed ones in address order
+     * @return true if anything changed
+     */
+    bool poll(std::vector<KittyMapChange> &changes);
+};
@@ -0,0 +1,328 @@
+#include "KittyMemCache.hpp"
+
+KittyMemCache::KittyMemCache(IKittyMemOp *pMem, size_t maxPages)
+    : _pMem(pMem), _maxPages(std::max(maxPages, size_t(1))), _pageSize(KT_PAGE_SIZE), _generation(0), _hits(0), _misses(0)
+{
+    _pid = pMem ? pMem->remotePID() : 0;
+
+    _storage.resize(_maxPages * _pageSize);
+    _pages.reserve(_maxPages);
+    _freeSlots.reserve(_maxPages);
+    for (size_t i = _maxPages; i > 0; i--)
+        _freeSlots.push_back(i - 1);
+}
+
+bool KittyMemCache::init(pid_t pid)
+{
+    invalidate();
+
+    _pid = pid;
+    if (!_pMem || pid < 1)
+        return false;
+
+    return _pMem->remotePID() == pid || _pMem->init(pid);
+}
+
+void KittyMemCache::dropPage(std::unordered_map<uintptr_t, std::list<Page>::iterator>::iterator it) const
+{
+    _freeSlots.push_back(it->second->slot);
+    _lru.erase(it->second);
+    _pages.erase(it);
+}
+
+const KittyMemCache::Page *KittyMemCache::touchPage(uintptr_t page) const
+{
+    auto it = _pages.find(page);
+    if (it == _pages.end() || it->second->generation != _generation)
+        return nullptr;
+
+    _lru.splice(_lru.begin(), _lru, it->second);
+    return &*it->second;
+}
+
+size_t KittyMemCache::copyCached(uintptr_t address, char *buffer, size_t len) const
+{
+    size_t copied = 0;
+    while (copied < len)
+    {
+        const uintptr_t current = address + copied;
+        const uintptr_t page = current & ~(_pageSize - 1);
+
+        auto it = _pages.find(page);
+        if (it == _pages.end() || it->second->generation != _generation)
+            break;
+
+        const size_t offset = current - page;
+        const size_t n = std::min(size_t(_pageSize - offset), len - copied);
+        memcpy(buffer + copied, slotData(it->second->slot) + offset, n);
+        copied += n;
+    }
+    return copied;
+}
+
+void KittyMemCache::updateCached(uintptr_t address, const char *buffer, size_t len) const
+{
+    for (size_t done = 0; done < len;)
+    {
+        const uintptr_t current = address + done;
+        const uintptr_t page = current & ~(_pageSize - 1);
+        const size_t offset = current - page;
+        const size_t n = std::min(size_t(_pageSize - offset), len - done);
+
+        auto it = _pages.find(page);
+        if (it != _pages.end())
+            memcpy(slotData(it->second->slot) + offset, buffer + done, n);
+
+        done += n;
+    }
+}
+
+size_t KittyMemCache::readCached(KittyMemRequest *requests, size_t count) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    const size_t maxRequestPages = std::max(_maxPages / 4, size_t(1));
+
+    // one request per missing page, fetched together
+    std::vector<KittyMemRequest> fetch;
+    // requests too large for the cache
+    std::vector<size_t> direct;
+    // pages of this batch stay at the front so they are never evicted by each other
+    size_t batchPages = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        KittyMemRequest &req = requests[i];
+        req.bytes = 0;
+        if (!req.address || !req.buffer || !req.len)
+            continue;
+
+        const uintptr_t first = req.address & ~(_pageSize - 1);
+        const uintptr_t last = (req.address + req.len - 1) & ~(_pageSize - 1);
+        const size_t npages = ((last - first) / _pageSize) + 1;
+        if (npages > maxRequestPages || batchPages + npages > _maxPages)
+        {
+            direct.push_back(i);
+            continue;
+        }
+
+        batchPages += npages;
+
+        for (uintptr_t page = first;; page += _pageSize)
+        {
+            if (touchPage(page))
+            {
+                _hits++;
+            }
+            else
+            {
+                _misses++;
+
+                size_t slot = 0;
+                auto it = _pages.find(page);
+                if (it != _pages.end())
+                {
+                    // stale, refetch in place
+                    it->second->generation = _generation;
+                    _lru.splice(_lru.begin(), _lru, it->second);
+                    slot = it->second->slot;
+                }
+                else
+                {
+                    if (_freeSlots.empty())
+                    {
+                        slot = _lru.back().slot;
+                        _pages.erase(_lru.back().address);
+                        _lru.pop_back();
+                    }
+                    else
+                    {
+                        slot = _freeSlots.back();
+                        _freeSlots.pop_back();
+                    }
+
+                    _lru.push_front({page, slot, _generation});
+                    _pages[page] = _lru.begin();
+                }
+
+                fetch.emplace_back(page, slotData(slot), size_t(_pageSize));
+            }
+
+            if (page == last)
+                break;
+        }
+    }
+
+    if (!fetch.empty())
+    {
+        _pMem->ReadBatch(fetch.data(), fetch.size());
+
+        // unreadable pages are not cached
+        for (auto &it : fetch)
+        {
+            if (it.bytes != it.len)
+            {
+                auto page = _pages.find(it.address);
+                if (page != _pages.end())
+                    dropPage(page);
+            }
+        }
+    }
+
+    size_t total = 0;
+    for (size_t i = 0, d = 0; i < count; i++)
+    {
+        if (d < direct.size() && direct[d] == i)
+        {
+            d++;
+            continue;
+        }
+
+        KittyMemRequest &req = requests[i];
+        if (req.address && req.buffer && req.len)
+        {
+            req.bytes = copyCached(req.address, (char *)req.buffer, req.len);
+            total += req.bytes;
+        }
+    }
+
+    // large reads don't touch the cache, other threads keep using it meanwhile
+    lock.unlock();
+
+    if (!direct.empty())
+    {
+        std::vector<KittyMemRequest> directRequests;
+        directRequests.reserve(direct.size());
+        for (size_t i : direct)
+            directRequests.push_back(requests[i]);
+
+        total += _pMem->ReadBatch(directRequests.data(), directRequests.size());
+        for (size_t i = 0; i < direct.size(); i++)
+            requests[direct[i]].bytes = directRequests[i].bytes;
+    }
+
+    return total;
+}
+
+size_t KittyMemCache::Read(uintptr_t address, void *buffer, size_t len) const
+{
+    if (!_pMem || !address || !buffer || !len)
+        return 0;
+
+    KittyMemRequest req(address, buffer, len);
+    return readCached(&req, 1);
+}
+
+size_t KittyMemCache::ReadBatch(KittyMemRequest *requests, size_t count) const
+{
+    if (!_pMem || !requests || !count)
+        return 0;
+
+    return readCached(requests, count);
+}
+
+size_t KittyMemCache::Write(uintptr_t address, void *buffer, size_t len) const
+{
+    if (!_pMem || !address || !buffer || !len)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t bytes = _pMem->Write(address, buffer, len);
+    if (bytes)
+        updateCached(address, (const char *)buffer, bytes);
+
+    return bytes;
+}
+
+size_t KittyMemCache::WriteBatch(KittyMemRequest *requests, size_t count) const
+{
+    if (!_pMem || !requests || !count)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t total = _pMem->WriteBatch(requests, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (requests[i].bytes)
+            updateCached(requests[i].address, (const char *)requests[i].buffer, requests[i].bytes);
+    }
+
+    return total;
+}
+
+void KittyMemCache::nextGeneration()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _generation++;
+}
+
+void KittyMemCache::invalidate()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _lru.clear();
+    _pages.clear();
+    _freeSlots.clear();
+    for (size_t i = _maxPages; i > 0; i--)
+        _freeSlots.push_back(i - 1);
+}
+
+void KittyMemCache::invalidate(uintptr_t address, size_t len)
+{
+    if (!len)
+        return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const uintptr_t first = address & ~(_pageSize - 1);
+    const uintptr_t last = (address + len - 1) & ~(_pageSize - 1);
+
+    // walk whichever is smaller, the range or the cached pages
+    if ((last - first) / _pageSize >= _pages.size())
+    {
+        for (auto it = _pages.begin(); it != _pages.end();)
+        {
+            auto next = std::next(it);
+            if (it->first >= first && it->first <= last)
+                dropPage(it);
+            it = next;
+        }
+        return;
+    }
+
+    for (uintptr_t page = first;; page += _pageSize)
+    {
+        auto it = _pages.find(page);
+        if (it != _pages.end())
+            dropPage(it);
+
+        if (page == last)
+            break;
+    }
+}
+
+size_t KittyMemCache::cachedPages() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _pages.size();
+}
+
+uint64_t KittyMemCache::generation() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _generation;
+}
+
+size_t KittyMemCache::hits() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _hits;
+}
+
+size_t KittyMemCache::misses() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _misses;
+}
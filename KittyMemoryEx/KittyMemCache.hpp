@@ -0,0 +1,110 @@
+#pragma once
+
+#include "KittyUtils.hpp"
+#include "KittyMemOp.hpp"
+
+#include <list>
+#include <unordered_map>
+#include <mutex>
+
+// default number of cached pages
+#define KT_MEM_CACHE_PAGES 1024
+
+/**
+ * Caching decorator of a memory operation, keeps an LRU of remote pages.
+ *
+ * Reads are served from cached pages, missing pages of a read or of a whole batch are fetched
+ * with a single ReadBatch of the wrapped operation. Writes go through & update cached pages.
+ *
+ * Cached pages belong to a generation, calling nextGeneration (e.g. once per frame) makes
+ * all of them stale without touching them, stale pages are refetched on next use.
+ * Reads larger than a quarter of the cache bypass it.
+ */
+class KittyMemCache : public IKittyMemOp
+{
+private:
+    IKittyMemOp *_pMem;
+    size_t _maxPages;
+    uintptr_t _pageSize;
+    uint64_t _generation;
+
+    struct Page
+    {
+        uintptr_t address;
+        // index of page data in storage
+        size_t slot;
+        uint64_t generation;
+    };
+
+    mutable std::mutex _mutex;
+    // most recently used first
+    mutable std::list<Page> _lru;
+    mutable std::unordered_map<uintptr_t, std::list<Page>::iterator> _pages;
+    mutable std::vector<char> _storage;
+    mutable std::vector<size_t> _freeSlots;
+    mutable size_t _hits, _misses;
+
+    inline char *slotData(size_t slot) const { return _storage.data() + (slot * _pageSize); }
+
+    // drop page & free its slot
+    void dropPage(std::unordered_map<uintptr_t, std::list<Page>::iterator>::iterator it) const;
+
+    // fresh page moved to front or nullptr
+    const Page *touchPage(uintptr_t page) const;
+
+    // copy cached bytes of [address, address + len) up to the first missing page
+    size_t copyCached(uintptr_t address, char *buffer, size_t len) const;
+
+    // update cached pages with written bytes
+    void updateCached(uintptr_t address, const char *buffer, size_t len) const;
+
+    size_t readCached(KittyMemRequest *requests, size_t count) const;
+
+public:
+    KittyMemCache() : _pMem(nullptr), _maxPages(0), _pageSize(0), _generation(0), _hits(0), _misses(0) {}
+
+    /**
+     * @param pMem: wrapped memory operation, not owned
+     * @param maxPages: max number of cached pages
+     */
+    KittyMemCache(IKittyMemOp *pMem, size_t maxPages = KT_MEM_CACHE_PAGES);
+
+    /**
+     * Cache is cleared, wrapped operation is initialized if its pid differs
+     */
+    bool init(pid_t pid);
+
+    size_t Read(uintptr_t address, void *buffer, size_t len) const;
+    size_t Write(uintptr_t address, void *buffer, size_t len) const;
+
+    // missing pages of all requests are fetched together
+    size_t ReadBatch(KittyMemRequest *requests, size_t count) const;
+    size_t WriteBatch(KittyMemRequest *requests, size_t count) const;
+
+    inline IKittyMemOp *memOp() const { return _pMem; }
+
+    /**
+     * Make all cached pages stale
+     */
+    void nextGeneration();
+
+    uint64_t generation() const;
+
+    /**
+     * Drop all cached pages
+     */
+    void invalidate();
+
+    /**
+     * Drop cached pages overlapping range
+     */
+    void invalidate(uintptr_t address, size_t len);
+
+    size_t cachedPages() const;
+
+    inline size_t maxPages() const { return _maxPages; }
+
+    // number of pages served from cache & fetched since creation
+    size_t hits() const;
+    size_t misses() const;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "KittyMemOp.hpp"
+
+#include <array>
+#include <type_traits>
+
+template <typename M>
+struct KittyMemberTraits;
+
+template <typename C, typename U>
+struct KittyMemberTraits<U C::*>
+{
+    using class_type = C;
+    using member_type = U;
+};
+
+/**
+ * One field of a remote struct, member of the local struct & its offset in the remote one
+ *
+ * e.g. KittyField<&Entity::health, 0x120>
+ */
+template <auto Member, uintptr_t Offset>
+struct KittyField
+{
+    static_assert(std::is_member_object_pointer<decltype(Member)>::value, "KittyField member must be a data member pointer");
+
+    using class_type = typename KittyMemberTraits<decltype(Member)>::class_type;
+    using member_type = typename KittyMemberTraits<decltype(Member)>::member_type;
+
+    static_assert(std::is_trivially_copyable<member_type>::value, "KittyField member must be trivially copyable");
+
+    static constexpr uintptr_t offset = Offset;
+    static constexpr size_t size = sizeof(member_type);
+
+    static inline KittyMemRequest request(uintptr_t base, class_type &out)
+    {
+        return KittyMemRequest(base + Offset, &(out.*Member), size);
+    }
+};
+
+/**
+ * Compile time list of fields of a remote struct read into a local T,
+ * all fields of one or many structs are read with a single ReadBatch
+ *
+ * e.g.
+ * using EntityLayout = KittyLayout<Entity,
+ *                                  KittyField<&Entity::health, 0x120>,
+ *                                  KittyField<&Entity::pos, 0x40>>;
+ */
+template <typename T, typename... Fields>
+struct KittyLayout
+{
+    static_assert(sizeof...(Fields) > 0, "KittyLayout needs at least one field");
+    static_assert((std::is_same<typename Fields::class_type, T>::value && ...), "KittyLayout fields must be members of T");
+
+    using type = T;
+
+    static constexpr size_t count = sizeof...(Fields);
+
+    // total bytes of all fields
+    static constexpr size_t size = (Fields::size + ...);
+
+    /**
+     * Fill count requests reading fields of struct at base into out
+     */
+    static inline void requests(uintptr_t base, T &out, KittyMemRequest *reqs)
+    {
+        size_t i = 0;
+        ((reqs[i++] = Fields::request(base, out)), ...);
+    }
+
+    /**
+     * Read all fields of struct at base with one ReadBatch
+     * @return true if every field was fully read
+     */
+    static bool read(const IKittyMemOp *pMem, uintptr_t base, T &out)
+    {
+        if (!pMem || !base)
+            return false;
+
+        std::array<KittyMemRequest, count> reqs;
+        requests(base, out, reqs.data());
+        return pMem->ReadBatch(reqs.data(), count) == size;
+    }
+
+    /**
+     * Read fields of many structs with one ReadBatch
+     * @param out: resized to bases count
+     * @param valid: optional, receives whether each struct was fully read
+     * @return number of fully read structs
+     */
+    static size_t readBatch(const IKittyMemOp *pMem, const std::vector<uintptr_t> &bases, std::vector<T> &out,
+                            std::vector<bool> *valid = nullptr)
+    {
+        out.resize(bases.size());
+        if (valid)
+            valid->assign(bases.size(), false);
+
+        if (!pMem || bases.empty())
+            return 0;
+
+        std::vector<KittyMemRequest> reqs(bases.size() * count);
+        for (size_t i = 0; i < bases.size(); i++)
+        {
+            if (bases[i])
+                requests(bases[i], out[i], reqs.data() + (i * count));
+        }
+
+        pMem->ReadBatch(reqs.data(), reqs.size());
+
+        size_t complete = 0;
+        for (size_t i = 0; i < bases.size(); i++)
+        {
+            const KittyMemRequest *it = reqs.data() + (i * count);
+            size_t bytes = 0;
+            for (size_t f = 0; f < count; f++)
+                bytes += it[f].bytes;
+
+            if (bases[i] && bytes == size)
+            {
+                complete++;
+                if (valid)
+                    (*valid)[i] = true;
+            }
+        }
+        return complete;
+    }
+};
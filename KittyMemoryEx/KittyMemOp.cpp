@@ -1,5 +1,14 @@
 #include "KittyMemOp.hpp"
+#include "KittyMemoryEx.hpp"
 #include <cerrno>
+#include <climits>
+#include <sys/uio.h>
+
+#ifdef IOV_MAX
+#define KT_IOV_MAX IOV_MAX
+#else
+#define KT_IOV_MAX 1024
+#endif
 
 // process_vm_readv & process_vm_writev
 #if defined(__aarch64__)
@@ -34,30 +43,367 @@ static ssize_t call_process_vm_writev(pid_t pid,
     return syscall(syscall_wpmv_n, pid, lvec, liovcnt, rvec, riovcnt, flags);
 }
 
+// transfers requests in packs of up to KT_IOV_MAX iovecs per syscall
+static size_t process_vm_batch(pid_t pid, KittyMemRequest *requests, size_t count, bool write)
+{
+    const char *op = write ? "WriteBatch" : "ReadBatch";
+
+    // an early return leaves requests of later packs at 0 instead of stale values
+    for (size_t i = 0; i < count; i++)
+        requests[i].bytes = 0;
+
+    // per thread pack buffers, too large for small worker & android thread stacks
+    static thread_local std::vector<iovec> local, remote;
+    static thread_local std::vector<size_t> index;
+    const size_t packSize = std::min<size_t>(count, KT_IOV_MAX);
+    if (local.size() < packSize)
+    {
+        local.resize(packSize);
+        remote.resize(packSize);
+        index.resize(packSize);
+    }
+
+    size_t total = 0, i = 0;
+    while (i < count)
+    {
+        size_t n = 0, next = i;
+        for (; next < count && n < KT_IOV_MAX; next++)
+        {
+            auto &req = requests[next];
+            if (!req.address || !req.buffer || !req.len)
+                continue;
+
+            local[n].iov_base = req.buffer;
+            local[n].iov_len = req.len;
+            remote[n].iov_base = (void *)req.address;
+            remote[n].iov_len = req.len;
+            index[n] = next;
+            n++;
+        }
+
+        if (!n)
+            break;
+
+        errno = 0;
+        ssize_t bytes = write ? call_process_vm_writev(pid, local.data(), n, remote.data(), n, 0)
+                              : call_process_vm_readv(pid, local.data(), n, remote.data(), n, 0);
+        if (bytes == -1)
+        {
+            int err = errno;
+            switch (err)
+            {
+            case EPERM:
+                KITTY_LOGE("%s: Can't access the address space of process ID (%d).", op, pid);
+                return total;
+            case ESRCH:
+                KITTY_LOGE("%s: No process with ID (%d) exists.", op, pid);
+                return total;
+            case ENOMEM:
+                KITTY_LOGE("%s: Could not allocate memory for internal copies of the iovec structures.", op);
+                return total;
+            case EFAULT:
+                // first remote iovec is inaccessible, skip it
+                KITTY_LOGD("%s: address (%p) with len (0x%zx) is inaccessible.", op, remote[0].iov_base, remote[0].iov_len);
+                i = index[0] + 1;
+                continue;
+            default:
+                KITTY_LOGD("%s: error=%d | %s.", op, err, strerror(err));
+                return total;
+            }
+        }
+
+        total += bytes;
+
+        // distribute transferred bytes, a partial transfer stops at the first faulting iovec
+        size_t remaining = bytes;
+        i = next;
+        for (size_t k = 0; k < n; k++)
+        {
+            auto &req = requests[index[k]];
+            req.bytes = std::min(remaining, req.len);
+            remaining -= req.bytes;
+            if (req.bytes != req.len)
+            {
+                i = index[k] + 1;
+                break;
+            }
+        }
+    }
+
+    return total;
+}
+
 /* =================== IKittyMemOp =================== */
 
-std::string IKittyMemOp::ReadStr(uintptr_t address, size_t maxLen)
+size_t IKittyMemOp::ReadBatch(KittyMemRequest *requests, size_t count) const
+{
+    size_t total = 0;
+    for (size_t i = 0; requests && i < count; i++)
+    {
+        requests[i].bytes = Read(requests[i].address, requests[i].buffer, requests[i].len);
+        total += requests[i].bytes;
+    }
+    return total;
+}
+
+size_t IKittyMemOp::WriteBatch(KittyMemRequest *requests, size_t count) const
+{
+    size_t total = 0;
+    for (size_t i = 0; requests && i < count; i++)
+    {
+        requests[i].bytes = Write(requests[i].address, requests[i].buffer, requests[i].len);
+        total += requests[i].bytes;
+    }
+    return total;
+}
+
+size_t IKittyMemOp::ReadPages(uintptr_t address, void *buffer, size_t len, std::vector<bool> *pagesValid) const
+{
+    return readPages(address, buffer, len, nullptr, pagesValid);
+}
+
+size_t IKittyMemOp::ReadPages(uintptr_t address, void *buffer, size_t len, const std::vector<KittyMemoryEx::ProcMap> &maps,
+                              std::vector<bool> *pagesValid) const
+{
+    return readPages(address, buffer, len, &maps, pagesValid);
+}
+
+size_t IKittyMemOp::readPages(uintptr_t address, void *buffer, size_t len, const std::vector<KittyMemoryEx::ProcMap> *maps,
+                              std::vector<bool> *pagesValid) const
 {
-    std::vector<char> chars(maxLen);
+    if (pagesValid)
+        pagesValid->clear();
+
+    if (_pid < 1 || !address || !buffer || !len)
+        return 0;
+
+    const uintptr_t pageSize = KT_PAGE_SIZE;
+    const uintptr_t end = address + len;
+    const uintptr_t firstPage = KT_PAGE_START(address);
 
-    if (!Read(address, &chars[0], maxLen))
-        return "";
+    if (pagesValid)
+        pagesValid->assign((KT_PAGE_END(end) - firstPage) / pageSize, true);
 
-    std::string str = "";
-    for (size_t i = 0; i < chars.size(); i++)
+    auto markInvalid = [&](uintptr_t from, uintptr_t to)
     {
-        if (chars[i] == '\0')
-            break;
+        memset((char *)buffer + (from - address), 0, to - from);
+        if (!pagesValid)
+            return;
+
+        for (uintptr_t page = KT_PAGE_START(from); page < to; page += pageSize)
+            (*pagesValid)[(page - firstPage) / pageSize] = false;
+    };
 
-        str.push_back(chars[i]);
+    // fast path, whole range is readable
+    size_t total = Read(address, buffer, len);
+    if (total == len)
+        return total;
+
+    uintptr_t current = address + total;
+
+    std::vector<KittyMemoryEx::ProcMap> parsedMaps;
+    if (!maps)
+    {
+        parsedMaps = KittyMemoryEx::getAllMaps(_pid);
+        maps = &parsedMaps;
     }
 
-    if ((int)str[0] == 0 && str.size() == 1)
-        return "";
+    // first map ending after current
+    auto map = std::upper_bound(maps->begin(), maps->end(), current, [](uintptr_t a, const KittyMemoryEx::ProcMap &m)
+                                { return a < m.endAddress; });
+    while (current < end)
+    {
+        while (map != maps->end() && map->endAddress <= current)
+            ++map;
+
+        // hole or unreadable map, skip it without touching remote memory
+        if (map == maps->end() || map->startAddress > current || !map->readable)
+        {
+            uintptr_t skipEnd = end;
+            if (map != maps->end())
+                skipEnd = std::min<uintptr_t>(end, map->startAddress > current ? map->startAddress : map->endAddress);
+
+            markInvalid(current, skipEnd);
+            current = skipEnd;
+            continue;
+        }
+
+        const uintptr_t segEnd = std::min<uintptr_t>(end, map->endAddress);
+        while (current < segEnd)
+        {
+            size_t bytes = Read(current, (char *)buffer + (current - address), segEnd - current);
+            total += bytes;
+            current += bytes;
+
+            if (current < segEnd)
+            {
+                // skip faulting page
+                uintptr_t pageEnd = std::min<uintptr_t>(segEnd, KT_PAGE_START(current) + pageSize);
+                markInvalid(current, pageEnd);
+                current = pageEnd;
+            }
+        }
+    }
+
+    return total;
+}
+
+// bytes to read at address, stops at the end of its page so a fault never drops bytes of a readable page
+static inline size_t strChunkSize(uintptr_t address, size_t chunk, size_t remaining, size_t pageSize)
+{
+    return std::min({chunk, pageSize - (address & (pageSize - 1)), remaining});
+}
+
+std::string IKittyMemOp::ReadStr(uintptr_t address, size_t maxLen) const
+{
+    std::string str;
+    if (!address || !maxLen)
+        return str;
+
+    const size_t pageSize = KT_PAGE_SIZE;
+    char chunk[KT_READ_STR_CHUNK];
+    std::vector<char> bigChunk;
+    char *buf = chunk;
+
+    for (size_t chunkSize = KT_READ_STR_CHUNK; str.size() < maxLen; chunkSize = std::min(chunkSize * 2, pageSize))
+    {
+        if (chunkSize > sizeof(chunk) && bigChunk.size() < chunkSize)
+        {
+            bigChunk.resize(chunkSize);
+            buf = bigChunk.data();
+        }
+
+        const uintptr_t current = address + str.size();
+        const size_t n = strChunkSize(current, chunkSize, maxLen - str.size(), pageSize);
+        const size_t bytes = Read(current, buf, n);
+
+        const char *nul = (const char *)memchr(buf, 0, bytes);
+        if (nul)
+        {
+            str.append(buf, nul - buf);
+            break;
+        }
+
+        str.append(buf, bytes);
+        if (bytes < n)
+            break;
+    }
 
     return str;
 }
 
+size_t IKittyMemOp::ReadStrBatch(const std::vector<uintptr_t> &addresses, size_t maxLen, std::vector<char> &arena,
+                                 std::vector<std::string_view> &strings) const
+{
+    arena.clear();
+    strings.assign(addresses.size(), std::string_view());
+
+    if (addresses.empty() || !maxLen)
+        return 0;
+
+    const size_t pageSize = KT_PAGE_SIZE;
+
+    // offset & length in arena of each string
+    std::vector<std::pair<size_t, size_t>> spans(addresses.size());
+
+    // strings not ended in the first round, rare & accumulated aside
+    struct LongString
+    {
+        size_t index;
+        std::string str;
+    };
+    std::vector<LongString> pending, done;
+
+    // first round reads straight into arena
+    std::vector<KittyMemRequest> requests;
+    requests.reserve(addresses.size());
+    size_t arenaSize = 0;
+    for (uintptr_t address : addresses)
+        arenaSize += address ? strChunkSize(address, KT_READ_STR_CHUNK, maxLen, pageSize) : 0;
+
+    arena.resize(arenaSize);
+    arenaSize = 0;
+    for (uintptr_t address : addresses)
+    {
+        const size_t n = address ? strChunkSize(address, KT_READ_STR_CHUNK, maxLen, pageSize) : 0;
+        requests.emplace_back(address, arena.data() + arenaSize, n);
+        arenaSize += n;
+    }
+
+    ReadBatch(requests.data(), requests.size());
+
+    for (size_t i = 0; i < requests.size(); i++)
+    {
+        const KittyMemRequest &req = requests[i];
+        if (!req.len)
+            continue;
+
+        const size_t offset = (const char *)req.buffer - arena.data();
+        const char *nul = req.bytes ? (const char *)memchr(req.buffer, 0, req.bytes) : nullptr;
+
+        if (nul)
+            spans[i] = {offset, size_t(nul - (const char *)req.buffer)};
+        else if (req.bytes < req.len || req.bytes == maxLen)
+            spans[i] = {offset, req.bytes};
+        else
+            pending.push_back({i, std::string((const char *)req.buffer, req.bytes)});
+    }
+
+    std::vector<char> round;
+    for (size_t chunkSize = KT_READ_STR_CHUNK * 2; !pending.empty(); chunkSize = std::min(chunkSize * 2, pageSize))
+    {
+        requests.clear();
+        size_t roundSize = 0;
+        for (auto &it : pending)
+            roundSize += strChunkSize(addresses[it.index] + it.str.size(), chunkSize, maxLen - it.str.size(), pageSize);
+
+        round.resize(roundSize);
+        roundSize = 0;
+        for (auto &it : pending)
+        {
+            const size_t n = strChunkSize(addresses[it.index] + it.str.size(), chunkSize, maxLen - it.str.size(), pageSize);
+            requests.emplace_back(addresses[it.index] + it.str.size(), round.data() + roundSize, n);
+            roundSize += n;
+        }
+
+        ReadBatch(requests.data(), requests.size());
+
+        size_t kept = 0;
+        for (size_t i = 0; i < pending.size(); i++)
+        {
+            const KittyMemRequest &req = requests[i];
+            LongString &it = pending[i];
+            const char *nul = req.bytes ? (const char *)memchr(req.buffer, 0, req.bytes) : nullptr;
+
+            it.str.append((const char *)req.buffer, nul ? size_t(nul - (const char *)req.buffer) : req.bytes);
+
+            if (nul || req.bytes < req.len || it.str.size() >= maxLen)
+                done.push_back(std::move(it));
+            else if (kept++ != i)
+                pending[kept - 1] = std::move(it);
+        }
+        pending.resize(kept);
+    }
+
+    for (auto &it : done)
+    {
+        spans[it.index] = {arena.size(), it.str.size()};
+        arena.insert(arena.end(), it.str.begin(), it.str.end());
+    }
+
+    // arena is final, views can be made
+    size_t total = 0;
+    for (size_t i = 0; i < spans.size(); i++)
+    {
+        if (spans[i].second)
+            strings[i] = std::string_view(arena.data() + spans[i].first, spans[i].second);
+
+        total += spans[i].second;
+    }
+
+    return total;
+}
+
 bool IKittyMemOp::WriteStr(uintptr_t address, std::string str)
 {
     size_t len = str.length() + 1; // extra for \0;
@@ -160,6 +506,22 @@ size_t KittyMemSys::Write(uintptr_t address, void *buffer, size_t len) const
     return bytes > 0 ? bytes : 0;
 }
 
+size_t KittyMemSys::ReadBatch(KittyMemRequest *requests, size_t count) const
+{
+    if (_pid < 1 || !requests || !count)
+        return 0;
+
+    return process_vm_batch(_pid, requests, count, false);
+}
+
+size_t KittyMemSys::WriteBatch(KittyMemRequest *requests, size_t count) const
+{
+    if (_pid < 1 || !requests || !count)
+        return 0;
+
+    return process_vm_batch(_pid, requests, count, true);
+}
+
 /* =================== KittyMemIO =================== */
 
 bool KittyMemIO::init(pid_t pid)
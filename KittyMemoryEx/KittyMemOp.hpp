@@ -2,6 +2,12 @@
 
 #include "KittyUtils.hpp"
 #include "KittyIOFile.hpp"
+#include "KittyMemoryEx.hpp"
+
+#include <string_view>
+
+// first chunk read by ReadStr, doubled on each read up to a page
+#define KT_READ_STR_CHUNK 64
 
 enum EKittyMemOP
 {
@@ -10,11 +16,27 @@ enum EKittyMemOP
     EK_MEM_OP_IO
 };
 
+struct KittyMemRequest
+{
+    uintptr_t address;
+    void *buffer;
+    size_t len;
+    // bytes transferred, set by ReadBatch & WriteBatch
+    size_t bytes;
+
+    KittyMemRequest() : address(0), buffer(nullptr), len(0), bytes(0) {}
+    KittyMemRequest(uintptr_t address, void *buffer, size_t len) : address(address), buffer(buffer), len(len), bytes(0) {}
+};
+
 class IKittyMemOp
 {
 protected:
     pid_t _pid;
 
+    // ReadPages with maps of pid parsed on the first short read if not given
+    size_t readPages(uintptr_t address, void *buffer, size_t len, const std::vector<KittyMemoryEx::ProcMap> *maps,
+                     std::vector<bool> *pagesValid) const;
+
 public:
     IKittyMemOp() : _pid(0) {}
     virtual ~IKittyMemOp() = default;
@@ -26,7 +48,56 @@ public:
     virtual size_t Read(uintptr_t address, void *buffer, size_t len) const = 0;
     virtual size_t Write(uintptr_t address, void *buffer, size_t len) const = 0;
 
-    std::string ReadStr(uintptr_t address, size_t maxLen);
+    /**
+     * Read multiple remote ranges, sets bytes of each request
+     * default implementation loops Read on each request
+     * @return total bytes read
+     */
+    virtual size_t ReadBatch(KittyMemRequest *requests, size_t count) const;
+
+    /**
+     * Write multiple remote ranges, sets bytes of each request
+     * default implementation loops Write on each request
+     * @return total bytes written
+     */
+    virtual size_t WriteBatch(KittyMemRequest *requests, size_t count) const;
+
+    /**
+     * Read remote range without stopping at the first unreadable page,
+     * the range is split at map and page boundaries and every readable page is read.
+     * Bytes of unmapped or unreadable pages are zero filled.
+     *
+     * @param pagesValid: optional, receives one flag per page starting from KT_PAGE_START(address)
+     *
+     * @return total bytes read
+     */
+    size_t ReadPages(uintptr_t address, void *buffer, size_t len, std::vector<bool> *pagesValid = nullptr) const;
+
+    /**
+     * Same as ReadPages but a short read is split using already parsed maps instead of reparsing /proc/[pid]/maps,
+     * for callers reading many ranges of the same maps
+     *
+     * @param maps: maps sorted by address, e.g. from getAllMaps or ProcMapSnapshot::maps
+     */
+    size_t ReadPages(uintptr_t address, void *buffer, size_t len, const std::vector<KittyMemoryEx::ProcMap> &maps,
+                     std::vector<bool> *pagesValid = nullptr) const;
+
+    /**
+     * Read string up to its null terminator or maxLen, in chunks that never cross a page,
+     * a fault keeps the bytes read before the unreadable page
+     */
+    std::string ReadStr(uintptr_t address, size_t maxLen) const;
+
+    /**
+     * Read many strings with one ReadBatch per chunk round, most strings end in the first round
+     *
+     * @param arena: receives string bytes, views in strings point into it
+     * @param strings: one view per address, empty if unreadable
+     *
+     * @return total length of read strings
+     */
+    size_t ReadStrBatch(const std::vector<uintptr_t> &addresses, size_t maxLen, std::vector<char> &arena,
+                        std::vector<std::string_view> &strings) const;
     bool WriteStr(uintptr_t address, std::string str);
 };
 
@@ -37,6 +108,10 @@ public:
 
     size_t Read(uintptr_t address, void *buffer, size_t len) const;
     size_t Write(uintptr_t address, void *buffer, size_t len) const;
+
+    // packs up to IOV_MAX requests per process_vm_readv / process_vm_writev call
+    size_t ReadBatch(KittyMemRequest *requests, size_t count) const;
+    size_t WriteBatch(KittyMemRequest *requests, size_t count) const;
 };
 
 class KittyMemIO : public IKittyMemOp
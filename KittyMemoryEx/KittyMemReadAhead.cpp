@@ -0,0 +1,234 @@
+#include "KittyMemReadAhead.hpp"
+
+KittyMemReadAhead::KittyMemReadAhead(IKittyMemOp *pMem, size_t readAheadSize)
+    : _pMem(pMem), _readAheadSize(std::max(readAheadSize, size_t(KT_READ_AHEAD_GAP))), _windowStart(0), _windowLen(0),
+      _lastStart(0), _lastEnd(0), _prefetches(0), _windowHits(0)
+{
+    _pid = pMem ? pMem->remotePID() : 0;
+    _window.resize(_readAheadSize);
+}
+
+bool KittyMemReadAhead::init(pid_t pid)
+{
+    invalidate();
+
+    _pid = pid;
+    if (!_pMem || pid < 1)
+        return false;
+
+    return _pMem->remotePID() == pid || _pMem->init(pid);
+}
+
+size_t KittyMemReadAhead::Read(uintptr_t address, void *buffer, size_t len) const
+{
+    if (!_pMem || !address || !buffer || !len)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const uintptr_t end = address + len;
+
+    // still moving forward inside the window
+    if (_windowLen && address > _lastStart && address >= _windowStart && end <= _windowStart + _windowLen)
+    {
+        memcpy(buffer, _window.data() + (address - _windowStart), len);
+        _windowHits++;
+        _lastStart = address;
+        _lastEnd = end;
+        return len;
+    }
+
+    const bool sequential = _lastEnd && nearLastRead(address);
+
+    _windowLen = 0;
+    _lastStart = address;
+    _lastEnd = end;
+
+    if (!sequential || len >= _readAheadSize)
+        return _pMem->Read(address, buffer, len);
+
+    // a window stopping before the end of the request hit an unreadable page
+    size_t bytes = _pMem->Read(address, _window.data(), _readAheadSize);
+    if (bytes < len)
+        return _pMem->Read(address, buffer, len);
+
+    _prefetches++;
+    _windowStart = address;
+    _windowLen = bytes;
+    memcpy(buffer, _window.data(), len);
+    return len;
+}
+
+size_t KittyMemReadAhead::ReadBatch(KittyMemRequest *requests, size_t count) const
+{
+    if (!_pMem || !requests || !count)
+        return 0;
+
+    std::vector<size_t> order;
+    order.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        requests[i].bytes = 0;
+        if (requests[i].address && requests[i].buffer && requests[i].len)
+            order.push_back(i);
+    }
+
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+              { return requests[a].address < requests[b].address; });
+
+    struct Group
+    {
+        uintptr_t start, end;
+        // range in order
+        size_t first, last;
+        // offset in merged buffer, unused for single request groups
+        size_t offset;
+    };
+    std::vector<Group> groups;
+    size_t mergedSize = 0;
+
+    for (size_t k = 0; k < order.size(); k++)
+    {
+        const KittyMemRequest &req = requests[order[k]];
+        const uintptr_t reqEnd = req.address + req.len;
+
+        if (!groups.empty())
+        {
+            Group &g = groups.back();
+            const uintptr_t newEnd = std::max(g.end, reqEnd);
+            if (req.address <= g.end + KT_READ_AHEAD_GAP && newEnd - g.start <= _readAheadSize)
+            {
+                g.end = newEnd;
+                g.last = k;
+                continue;
+            }
+        }
+
+        groups.push_back({req.address, reqEnd, k, k, 0});
+    }
+
+    for (auto &g : groups)
+    {
+        if (g.first != g.last)
+        {
+            g.offset = mergedSize;
+            mergedSize += g.end - g.start;
+        }
+    }
+
+    // single request groups read straight into their buffer
+    std::vector<char> merged(mergedSize);
+    std::vector<KittyMemRequest> ranges;
+    ranges.reserve(groups.size());
+    for (auto &g : groups)
+    {
+        if (g.first == g.last)
+            ranges.push_back(requests[order[g.first]]);
+        else
+            ranges.emplace_back(g.start, merged.data() + g.offset, size_t(g.end - g.start));
+    }
+
+    _pMem->ReadBatch(ranges.data(), ranges.size());
+
+    size_t total = 0;
+    // requests cut by an unreadable gap between merged requests are read again alone
+    std::vector<KittyMemRequest> retry;
+    std::vector<size_t> retryIndex;
+
+    for (size_t gi = 0; gi < groups.size(); gi++)
+    {
+        const Group &g = groups[gi];
+        const uintptr_t readEnd = g.start + ranges[gi].bytes;
+
+        for (size_t k = g.first; k <= g.last; k++)
+        {
+            KittyMemRequest &req = requests[order[k]];
+
+            if (g.first == g.last)
+            {
+                req.bytes = ranges[gi].bytes;
+            }
+            else
+            {
+                req.bytes = readEnd > req.address ? std::min(size_t(readEnd - req.address), req.len) : 0;
+                if (req.bytes)
+                    memcpy(req.buffer, merged.data() + g.offset + (req.address - g.start), req.bytes);
+
+                if (req.bytes != req.len)
+                {
+                    retry.push_back(req);
+                    retryIndex.push_back(order[k]);
+                    continue;
+                }
+            }
+
+            total += req.bytes;
+        }
+    }
+
+    if (!retry.empty())
+    {
+        _pMem->ReadBatch(retry.data(), retry.size());
+        for (size_t i = 0; i < retry.size(); i++)
+        {
+            requests[retryIndex[i]].bytes = retry[i].bytes;
+            total += retry[i].bytes;
+        }
+    }
+
+    return total;
+}
+
+size_t KittyMemReadAhead::Write(uintptr_t address, void *buffer, size_t len) const
+{
+    if (!_pMem || !address || !buffer || !len)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t bytes = _pMem->Write(address, buffer, len);
+
+    // keep window in sync with written bytes
+    const uintptr_t from = std::max(address, _windowStart);
+    const uintptr_t to = std::min(address + bytes, _windowStart + _windowLen);
+    if (_windowLen && from < to)
+        memcpy(_window.data() + (from - _windowStart), (const char *)buffer + (from - address), to - from);
+
+    return bytes;
+}
+
+size_t KittyMemReadAhead::WriteBatch(KittyMemRequest *requests, size_t count) const
+{
+    if (!_pMem || !requests || !count)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t total = _pMem->WriteBatch(requests, count);
+
+    // written ranges may overlap the window, dropping it is simpler than patching
+    if (total)
+        _windowLen = 0;
+
+    return total;
+}
+
+void KittyMemReadAhead::invalidate()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _windowLen = 0;
+    _lastStart = _lastEnd = 0;
+}
+
+size_t KittyMemReadAhead::prefetches() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _prefetches;
+}
+
+size_t KittyMemReadAhead::windowHits() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _windowHits;
+}
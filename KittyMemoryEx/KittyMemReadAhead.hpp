@@ -0,0 +1,77 @@
+#pragma once
+
+#include "KittyUtils.hpp"
+#include "KittyMemOp.hpp"
+
+#include <mutex>
+
+// default bytes prefetched once reads are sequential
+#define KT_READ_AHEAD_SIZE (64 * 1024)
+
+// max gap between reads still considered sequential, and between merged batch requests
+#define KT_READ_AHEAD_GAP 256
+
+/**
+ * Read-ahead decorator of a memory operation for callers issuing many small nearly adjacent reads.
+ *
+ * After two reads close to each other, the next read fetches a whole window in one call
+ * and following reads are served from it while they keep moving forward.
+ * A read behind the previous one or outside the window drops it, so polling the same addresses
+ * always reads fresh memory.
+ *
+ * ReadBatch sorts requests & merges close ones into single ranges.
+ * Writes go through & update the window.
+ */
+class KittyMemReadAhead : public IKittyMemOp
+{
+private:
+    IKittyMemOp *_pMem;
+    size_t _readAheadSize;
+
+    mutable std::mutex _mutex;
+    mutable std::vector<char> _window;
+    mutable uintptr_t _windowStart;
+    mutable size_t _windowLen;
+    // start & end of previous read
+    mutable uintptr_t _lastStart, _lastEnd;
+    mutable size_t _prefetches, _windowHits;
+
+    inline bool nearLastRead(uintptr_t address) const
+    {
+        // strictly forward, rereading the same address is not sequential
+        return address > _lastStart && address <= _lastEnd + KT_READ_AHEAD_GAP;
+    }
+
+public:
+    KittyMemReadAhead() : _pMem(nullptr), _readAheadSize(0), _windowStart(0), _windowLen(0),
+                          _lastStart(0), _lastEnd(0), _prefetches(0), _windowHits(0) {}
+
+    /**
+     * @param pMem: wrapped memory operation, not owned
+     * @param readAheadSize: bytes fetched by each prefetch
+     */
+    KittyMemReadAhead(IKittyMemOp *pMem, size_t readAheadSize = KT_READ_AHEAD_SIZE);
+
+    /**
+     * Window is dropped, wrapped operation is initialized if its pid differs
+     */
+    bool init(pid_t pid);
+
+    size_t Read(uintptr_t address, void *buffer, size_t len) const;
+    size_t Write(uintptr_t address, void *buffer, size_t len) const;
+
+    // close requests are merged into one range
+    size_t ReadBatch(KittyMemRequest *requests, size_t count) const;
+    size_t WriteBatch(KittyMemRequest *requests, size_t count) const;
+
+    inline IKittyMemOp *memOp() const { return _pMem; }
+
+    /**
+     * Drop prefetched window
+     */
+    void invalidate();
+
+    // number of windows fetched & reads served from them since creation
+    size_t prefetches() const;
+    size_t windowHits() const;
+};
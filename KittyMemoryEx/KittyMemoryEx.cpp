@@ -1,26 +1,81 @@
 #include "KittyMemoryEx.hpp"
 
+#include <regex>
+#include <mutex>
+#include <sys/syscall.h>
+
+#ifndef __NR_pidfd_open
+#define __NR_pidfd_open 434
+#endif
+
 namespace KittyMemoryEx
 {
+    // reads up to size bytes of /proc/[pid]/[name], -1 if it can't be opened
+    static ssize_t readProcFile(pid_t pid, const char *name, char *buf, size_t size)
+    {
+        char filePath[64] = {0};
+        snprintf(filePath, sizeof(filePath), "/proc/%d/%s", pid, name);
+
+        int fd = open(filePath, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return -1;
+
+        size_t used = 0;
+        while (used < size)
+        {
+            ssize_t n = read(fd, buf + used, size - used);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+
+            used += size_t(n);
+        }
+
+        close(fd);
+        return ssize_t(used);
+    }
+
+    // comm & start time from /proc/[pid]/stat
+    static bool readProcStat(pid_t pid, std::string_view &comm, unsigned long long &startTime, char *buf, size_t size)
+    {
+        ssize_t n = readProcFile(pid, "stat", buf, size - 1);
+        if (n <= 0)
+            return false;
+
+        buf[n] = 0;
+
+        // (format) pid (comm) state ppid ... starttime is field 22, comm may contain spaces & parentheses
+        char *open = strchr(buf, '('), *close = strrchr(buf, ')');
+        if (!open || !close || close < open)
+            return false;
+
+        comm = std::string_view(open + 1, size_t(close - open - 1));
+
+        const char *p = close + 1;
+        for (int field = 2; field < 22 && *p; p++)
+        {
+            if (*p == ' ')
+                field++;
+        }
+
+        startTime = strtoull(p, nullptr, 10);
+        return true;
+    }
+
     std::string getProcessName(pid_t pid)
     {
         if (pid <= 0)
             return "";
 
-        char filePath[256] = {0};
-        snprintf(filePath, sizeof(filePath), "/proc/%d/cmdline", pid);
-
+        char cmdline[128] = {0};
         errno = 0;
-        FILE *fp = fopen(filePath, "r");
-        if (!fp)
+        if (readProcFile(pid, "cmdline", cmdline, sizeof(cmdline) - 1) < 0)
         {
-            KITTY_LOGE("Couldn't open cmdline file %s, error=%s", filePath, strerror(errno));
+            KITTY_LOGE("Couldn't open cmdline file of %d, error=%s", pid, strerror(errno));
             return "";
         }
 
-        char cmdline[128] = {0};
-        fgets(cmdline, sizeof(cmdline), fp);
-        fclose(fp);
         return cmdline;
     }
 
@@ -29,31 +84,176 @@ namespace KittyMemoryEx
         if (processName.empty())
             return 0;
 
-        pid_t pid = 0;
+        // shared finder so repeated lookups reuse its cache
+        static std::mutex finderMutex;
+        static ProcessFinder finder;
+
+        std::lock_guard<std::mutex> lock(finderMutex);
+        return finder.findFirst(processName);
+    }
+
+    int openPidfd(pid_t pid)
+    {
+        return int(syscall(__NR_pidfd_open, pid, 0));
+    }
+
+    std::vector<ProcessInfo> ProcessFinder::find(const std::string &name, EProcessMatch match, bool openPidfds)
+    {
+        std::vector<ProcessInfo> results;
+        if (name.empty())
+            return results;
+
+        std::regex re;
+        if (match == EK_PROC_MATCH_REGEX)
+        {
+            try
+            {
+                re = std::regex(name, std::regex::ECMAScript | std::regex::optimize);
+            }
+            catch (const std::regex_error &e)
+            {
+                KITTY_LOGE("ProcessFinder: invalid regex \"%s\", %s", name.c_str(), e.what());
+                return results;
+            }
+        }
+
+        auto matches = [&](const std::string &procName)
+        {
+            switch (match)
+            {
+            case EK_PROC_MATCH_EXACT:
+                return procName == name;
+            case EK_PROC_MATCH_PREFIX:
+                return procName.compare(0, name.length(), name) == 0;
+            case EK_PROC_MATCH_REGEX:
+                return std::regex_search(procName, re);
+            }
+            return false;
+        };
 
         errno = 0;
         DIR *dir = opendir("/proc/");
         if (!dir)
         {
             KITTY_LOGE("Couldn't open /proc/, error=%s", strerror(errno));
-            return pid;
+            return results;
         }
 
+        // only processes seen in this pass are kept cached
+        std::unordered_map<pid_t, CachedProcess> seen;
+        seen.reserve(_cache.size());
+
+        char buf[1024];
         dirent *entry = nullptr;
         while ((entry = readdir(dir)) != nullptr)
         {
-            int entry_pid = atoi(entry->d_name);
-            if (entry_pid > 0)
+            pid_t pid = 0;
+            const char *d = entry->d_name;
+            for (; *d >= '0' && *d <= '9'; d++)
+                pid = (pid * 10) + (*d - '0');
+
+            if (*d || pid <= 0)
+                continue;
+
+            // cmdline is read every pass, exec or a zygote child setting its name keeps pid & inode
+            ssize_t n = readProcFile(pid, "cmdline", buf, sizeof(buf) - 1);
+            if (n < 0)
+                continue;
+
+            buf[n] = 0;
+
+            auto node = _cache.extract(pid);
+            const bool changed = node.empty() || node.mapped().inode != entry->d_ino ||
+                                 (buf[0] ? node.mapped().name != buf : !node.mapped().fromComm);
+            if (changed)
             {
-                if (processName == getProcessName(entry_pid))
+                CachedProcess proc;
+                proc.inode = entry->d_ino;
+                proc.startTime = 0;
+                proc.name = buf;
+                proc.fromComm = false;
+
+                // kernel threads have no cmdline
+                if (proc.name.empty())
                 {
-                    pid = entry_pid;
-                    break;
+                    std::string_view comm;
+                    if (!readProcStat(pid, comm, proc.startTime, buf, sizeof(buf)))
+                        continue;
+
+                    proc.comm.assign(comm.data(), comm.size());
+                    proc.name = proc.comm;
+                    proc.fromComm = true;
                 }
+
+                if (node.empty())
+                {
+                    seen.emplace(pid, std::move(proc));
+                }
+                else
+                {
+                    // reuse the node of a dead or renamed process with the same pid
+                    node.mapped() = std::move(proc);
+                    seen.insert(std::move(node));
+                }
+            }
+            else
+            {
+                seen.insert(std::move(node));
+            }
+
+            CachedProcess &proc = seen[pid];
+            if (!matches(proc.name))
+                continue;
+
+            // stat is only read for matches
+            if (!proc.startTime)
+            {
+                std::string_view comm;
+                if (!readProcStat(pid, comm, proc.startTime, buf, sizeof(buf)))
+                    continue;
+
+                proc.comm.assign(comm.data(), comm.size());
             }
+
+            ProcessInfo info;
+            info.pid = pid;
+            info.startTime = proc.startTime;
+            info.name = proc.name;
+            info.comm = proc.comm;
+            results.push_back(std::move(info));
         }
         closedir(dir);
-        return pid;
+
+        _cache.swap(seen);
+
+        if (openPidfds)
+        {
+            std::vector<ProcessInfo> opened;
+            for (auto &it : results)
+            {
+                it.pidfd = openPidfd(it.pid);
+
+                // pid may have been reused between reading stat & opening pidfd
+                std::string_view comm;
+                unsigned long long startTime = 0;
+                if (it.pidfd >= 0 && (!readProcStat(it.pid, comm, startTime, buf, sizeof(buf)) || startTime != it.startTime))
+                {
+                    close(it.pidfd);
+                    continue;
+                }
+
+                opened.push_back(std::move(it));
+            }
+            results.swap(opened);
+        }
+
+        return results;
+    }
+
+    pid_t ProcessFinder::findFirst(const std::string &name, EProcessMatch match)
+    {
+        auto results = find(name, match);
+        return results.empty() ? 0 : results.front().pid;
     }
 
     int getStatusInteger(pid_t pid, const std::string &var)
@@ -88,67 +288,245 @@ namespace KittyMemoryEx
         return retVal;
     }
 
-    std::vector<ProcMap> getAllMaps(pid_t pid)
+    // one line of maps file, dev & pathname point into the read buffer
+    struct MapsLine
     {
-        std::vector<ProcMap> retMaps;
-        if (pid <= 0)
-            return retMaps;
+        unsigned long long startAddress, endAddress, offset;
+        unsigned long inode;
+        uint32_t devMajor, devMinor;
+        char perms[4];
+        std::string_view dev, pathname;
+    };
+
+    // hex digit values, 0xFF for non hex characters
+    static const struct HexTable
+    {
+        uint8_t values[256];
+
+        HexTable()
+        {
+            memset(values, 0xFF, sizeof(values));
+            for (int i = 0; i < 10; i++)
+                values['0' + i] = uint8_t(i);
+            for (int i = 0; i < 6; i++)
+                values['a' + i] = values['A' + i] = uint8_t(10 + i);
+        }
+    } kHexTable;
+
+    static inline unsigned long long parseHex(const char *&p, const char *end)
+    {
+        unsigned long long v = 0;
+        for (; p < end; p++)
+        {
+            const uint8_t d = kHexTable.values[uint8_t(*p)];
+            if (d == 0xFF)
+                break;
+
+            v = (v << 4) | d;
+        }
+        return v;
+    }
+
+    static inline bool skipChar(const char *&p, const char *end, char c)
+    {
+        if (p >= end || *p != c)
+            return false;
+
+        p++;
+        return true;
+    }
+
+    // (format) startAddress-endAddress perms offset dev inode pathname
+    // pathname is the rest of the line so paths with spaces are kept
+    static bool parseMapsLine(const char *p, const char *end, MapsLine &line)
+    {
+        line.startAddress = parseHex(p, end);
+        if (!skipChar(p, end, '-'))
+            return false;
+
+        line.endAddress = parseHex(p, end);
+        if (!skipChar(p, end, ' ') || end - p < 5)
+            return false;
+
+        memcpy(line.perms, p, 4);
+        p += 4;
+        if (!skipChar(p, end, ' '))
+            return false;
+
+        line.offset = parseHex(p, end);
+        if (!skipChar(p, end, ' '))
+            return false;
+
+        const char *dev = p;
+        line.devMajor = uint32_t(parseHex(p, end));
+        if (!skipChar(p, end, ':'))
+            return false;
+
+        line.devMinor = uint32_t(parseHex(p, end));
+        line.dev = std::string_view(dev, size_t(p - dev));
+        if (!skipChar(p, end, ' '))
+            return false;
+
+        line.inode = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; p++)
+            line.inode = (line.inode * 10) + unsigned(*p - '0');
+
+        while (p < end && *p == ' ')
+            p++;
+
+        line.pathname = std::string_view(p, size_t(end - p));
+        return true;
+    }
+
+    static inline int permsProtection(const char *perms)
+    {
+        int protection = 0;
+        if (perms[0] == 'r')
+            protection |= PROT_READ;
+        if (perms[1] == 'w')
+            protection |= PROT_WRITE;
+        if (perms[2] == 'x')
+            protection |= PROT_EXEC;
+        return protection;
+    }
+
+    // parses complete lines of data, returns bytes consumed up to the last new line
+    template <typename F>
+    static size_t forEachMapsLineIn(const char *data, size_t size, MapsLine &line, F &&onLine)
+    {
+        const char *p = data, *end = data + size;
+        while (p < end)
+        {
+            const char *nl = (const char *)memchr(p, '\n', size_t(end - p));
+            if (!nl)
+                break;
+
+            if (parseMapsLine(p, nl, line))
+                onLine(line);
+
+            p = nl + 1;
+        }
+        return size_t(p - data);
+    }
 
+    static int openMapsFile(pid_t pid)
+    {
         char filePath[256] = {0};
         snprintf(filePath, sizeof(filePath), "/proc/%d/maps", pid);
 
         errno = 0;
-        FILE *fp = fopen(filePath, "r");
-        if (!fp)
+        int fd = open(filePath, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
         {
             KITTY_LOGE("Couldn't open maps file %s, error=%s", filePath, strerror(errno));
-            return retMaps;
         }
+        return fd;
+    }
 
-        char line[512] = {0};
-        while (fgets(line, sizeof(line), fp))
+    // reads maps file in blocks & calls onLine for each parsed line
+    template <typename F>
+    static bool forEachMapsLine(pid_t pid, F &&onLine)
+    {
+        int fd = openMapsFile(pid);
+        if (fd < 0)
+            return false;
+
+        // big enough for a line with a PATH_MAX pathname
+        char buf[16 * 1024];
+        size_t used = 0;
+        MapsLine line{};
+
+        while (true)
         {
-            ProcMap map;
-            map.pid = pid;
+            ssize_t n = read(fd, buf + used, sizeof(buf) - used);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
 
-            char perms[5] = {0}, dev[11] = {0}, pathname[256] = {0};
-            // parse a line in maps file
-            // (format) startAddress-endAddress perms offset dev inode pathname
-            sscanf(line, "%llx-%llx %s %llx %s %lu %s",
-                   &map.startAddress, &map.endAddress,
-                   perms, &map.offset, dev, &map.inode, pathname);
+            used += size_t(n);
+            const size_t consumed = forEachMapsLineIn(buf, used, line, onLine);
 
-            map.length = map.endAddress - map.startAddress;
-            map.dev = dev;
-            map.pathname = pathname;
+            // keep partial line for next read, drop it if it can't fit
+            used -= consumed;
+            if (used == sizeof(buf))
+                used = 0;
+            else if (used && consumed)
+                memmove(buf, buf + consumed, used);
+        }
 
-            if (perms[0] == 'r')
-            {
-                map.protection |= PROT_READ;
-                map.readable = true;
-            }
-            if (perms[1] == 'w')
-            {
-                map.protection |= PROT_WRITE;
-                map.writeable = true;
-            }
-            if (perms[2] == 'x')
-            {
-                map.protection |= PROT_EXEC;
-                map.executable = true;
-            }
+        if (used && parseMapsLine(buf, buf + used, line))
+            onLine(line);
+
+        close(fd);
+        return true;
+    }
+
+    bool readMapsFile(pid_t pid, std::string &buffer)
+    {
+        buffer.clear();
+        if (pid <= 0)
+            return false;
 
-            map.is_private = (perms[3] == 'p');
-            map.is_shared = (perms[3] == 's');
+        int fd = openMapsFile(pid);
+        if (fd < 0)
+            return false;
 
-            map.is_rx = (strncmp(perms, "r-x", 3) == 0);
-            map.is_rw = (strncmp(perms, "rw-", 3) == 0);
-            map.is_ro = (strncmp(perms, "r--", 3) == 0);
+        size_t used = 0;
+        buffer.resize(std::max<size_t>(buffer.capacity(), 64 * 1024));
+        while (true)
+        {
+            if (used == buffer.size())
+                buffer.resize(buffer.size() * 2);
 
-            retMaps.push_back(map);
+            ssize_t n = read(fd, &buffer[used], buffer.size() - used);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+
+            used += size_t(n);
         }
+        buffer.resize(used);
 
-        fclose(fp);
+        close(fd);
+        return used > 0;
+    }
+
+    std::vector<ProcMap> getAllMaps(pid_t pid)
+    {
+        std::vector<ProcMap> retMaps;
+        if (pid <= 0)
+            return retMaps;
+
+        if (!forEachMapsLine(pid, [&](const MapsLine &line)
+        {
+            retMaps.emplace_back();
+            ProcMap &map = retMaps.back();
+            map.pid = pid;
+            map.startAddress = line.startAddress;
+            map.endAddress = line.endAddress;
+            map.length = map.endAddress - map.startAddress;
+            map.offset = line.offset;
+            map.inode = line.inode;
+            map.dev.assign(line.dev.data(), line.dev.size());
+            map.pathname.assign(line.pathname.data(), line.pathname.size());
+
+            map.protection = permsProtection(line.perms);
+            map.readable = (map.protection & PROT_READ) != 0;
+            map.writeable = (map.protection & PROT_WRITE) != 0;
+            map.executable = (map.protection & PROT_EXEC) != 0;
+
+            map.is_private = (line.perms[3] == 'p');
+            map.is_shared = (line.perms[3] == 's');
+
+            map.is_rx = (strncmp(line.perms, "r-x", 3) == 0);
+            map.is_rw = (strncmp(line.perms, "rw-", 3) == 0);
+            map.is_ro = (strncmp(line.perms, "r--", 3) == 0);
+        }))
+        {
+            return retMaps;
+        }
 
         if (retMaps.empty())
         {
@@ -157,6 +535,107 @@ namespace KittyMemoryEx
         return retMaps;
     }
 
+    ProcMapTable::ProcMapTable() : _pid(0)
+    {
+        _strings.emplace_back();
+        _stringIds.emplace(std::string_view(_strings.back()), 0);
+    }
+
+    ProcMapTable::ProcMapTable(pid_t pid) : ProcMapTable()
+    {
+        _pid = pid;
+        refresh();
+    }
+
+    uint32_t ProcMapTable::intern(std::string_view str)
+    {
+        if (str.empty())
+            return 0;
+
+        auto it = _stringIds.find(str);
+        if (it != _stringIds.end())
+            return it->second;
+
+        const uint32_t id = uint32_t(_strings.size());
+        _strings.emplace_back(str);
+        _stringIds.emplace(std::string_view(_strings.back()), id);
+        return id;
+    }
+
+    void ProcMapTable::addEntry(const MapsLine &line)
+    {
+        // consecutive maps of a file share its pathname
+        uint32_t id = _entries.empty() ? 0 : _entries.back().pathname;
+        if (line.pathname != pathname(id))
+            id = intern(line.pathname);
+
+        ProcMapEntry entry;
+        entry.startAddress = line.startAddress;
+        entry.endAddress = line.endAddress;
+        entry.offset = line.offset;
+        entry.inode = line.inode;
+        entry.pathname = id;
+        entry.devMajor = line.devMajor;
+        entry.devMinor = line.devMinor;
+        entry.protection = uint8_t(permsProtection(line.perms));
+        entry.is_private = (line.perms[3] == 'p');
+        entry.is_shared = (line.perms[3] == 's');
+        _entries.push_back(entry);
+    }
+
+    bool ProcMapTable::refresh()
+    {
+        _entries.clear();
+
+        if (_pid <= 0)
+            return false;
+
+        forEachMapsLine(_pid, [&](const MapsLine &line)
+                        { addEntry(line); });
+
+        return !_entries.empty();
+    }
+
+    bool ProcMapTable::refresh(const std::string &rawMaps)
+    {
+        _entries.clear();
+
+        MapsLine line{};
+        const size_t consumed = forEachMapsLineIn(rawMaps.data(), rawMaps.size(), line, [&](const MapsLine &line)
+                                                  { addEntry(line); });
+
+        if (consumed < rawMaps.size() && parseMapsLine(rawMaps.data() + consumed, rawMaps.data() + rawMaps.size(), line))
+            addEntry(line);
+
+        return !_entries.empty();
+    }
+
+    ProcMap ProcMapTable::toProcMap(const ProcMapEntry &entry) const
+    {
+        ProcMap map;
+        map.pid = _pid;
+        map.startAddress = entry.startAddress;
+        map.endAddress = entry.endAddress;
+        map.length = entry.length();
+        map.offset = entry.offset;
+        map.inode = entry.inode;
+        map.dev = KittyUtils::strfmt("%02x:%02x", entry.devMajor, entry.devMinor);
+        map.pathname = pathname(entry);
+
+        map.protection = entry.protection;
+        map.readable = (entry.protection & PROT_READ) != 0;
+        map.writeable = (entry.protection & PROT_WRITE) != 0;
+        map.executable = (entry.protection & PROT_EXEC) != 0;
+
+        map.is_private = entry.is_private;
+        map.is_shared = entry.is_shared;
+
+        map.is_rx = entry.protection == (PROT_READ | PROT_EXEC);
+        map.is_rw = entry.protection == (PROT_READ | PROT_WRITE);
+        map.is_ro = entry.protection == PROT_READ;
+        return map;
+    }
+
     std::vector<ProcMap> getMapsEqual(pid_t pid, const std::string &name)
     {
         std::vector<ProcMap> retMaps;
@@ -237,4 +716,89 @@ namespace KittyMemoryEx
         return retMap;
     }
 
+    bool ProcMapSnapshot::refresh()
+    {
+        _maps = getAllMaps(_pid);
+        _pathIndex.clear();
+
+        std::sort(_maps.begin(), _maps.end(), [](const ProcMap &a, const ProcMap &b)
+                  { return a.startAddress < b.startAddress; });
+
+        for (size_t i = 0; i < _maps.size(); i++)
+        {
+            if (!_maps[i].isUnknown())
+                _pathIndex[_maps[i].pathname].push_back(i);
+        }
+
+        return !_maps.empty();
+    }
+
+    ProcMap ProcMapSnapshot::getAddressMap(uintptr_t address) const
+    {
+        auto it = std::upper_bound(_maps.begin(), _maps.end(), address, [](uintptr_t a, const ProcMap &m)
+                                   { return a < m.startAddress; });
+        if (it == _maps.begin())
+            return ProcMap();
+
+        --it;
+        return (it->isValid() && address < it->endAddress) ? *it : ProcMap();
+    }
+
+    std::vector<ProcMap> ProcMapSnapshot::collect(const std::function<bool(const std::string &)> &matchPath) const
+    {
+        std::vector<size_t> indexes;
+        for (auto &it : _pathIndex)
+        {
+            if (matchPath(it.first))
+                indexes.insert(indexes.end(), it.second.begin(), it.second.end());
+        }
+
+        // keep address order of maps file
+        std::sort(indexes.begin(), indexes.end());
+
+        std::vector<ProcMap> retMaps;
+        retMaps.reserve(indexes.size());
+        for (size_t i : indexes)
+        {
+            if (_maps[i].isValid())
+                retMaps.push_back(_maps[i]);
+        }
+        return retMaps;
+    }
+
+    std::vector<ProcMap> ProcMapSnapshot::getMapsEqual(const std::string &name) const
+    {
+        std::vector<ProcMap> retMaps;
+
+        auto it = _pathIndex.find(name);
+        if (it == _pathIndex.end())
+            return retMaps;
+
+        for (size_t i : it->second)
+        {
+            if (_maps[i].isValid())
+                retMaps.push_back(_maps[i]);
+        }
+        return retMaps;
+    }
+
+    std::vector<ProcMap> ProcMapSnapshot::getMapsContain(const std::string &name) const
+    {
+        if (name.empty())
+            return {};
+
+        return collect([&](const std::string &path)
+                       { return path.find(name) != std::string::npos; });
+    }
+
+    std::vector<ProcMap> ProcMapSnapshot::getMapsEndWith(const std::string &name) const
+    {
+        if (name.empty())
+            return {};
+
+        return collect([&](const std::string &path)
+                       { return path.length() >= name.length() &&
+                                path.compare(path.length() - name.length(), name.length(), name) == 0; });
+    }
+
 } // KittyMemoryEx
\ No newline at end of file
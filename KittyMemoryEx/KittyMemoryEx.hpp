@@ -2,6 +2,10 @@
 
 #include "KittyUtils.hpp"
 
+#include <unordered_map>
+#include <deque>
+#include <string_view>
+
 namespace KittyMemoryEx
 {
   class ProcMap
@@ -28,6 +32,74 @@ namespace KittyMemoryEx
     inline bool isUnknown() const { return pathname.empty(); }
   };
 
+  /*
+   * Compact POD map entry, pathname is an id in the owning ProcMapTable strings
+   */
+  struct ProcMapEntry
+  {
+    unsigned long long startAddress;
+    unsigned long long endAddress;
+    unsigned long long offset;
+    unsigned long inode;
+    uint32_t pathname;
+    uint32_t devMajor, devMinor;
+    uint8_t protection;
+    bool is_private, is_shared;
+
+    inline size_t length() const { return size_t(endAddress - startAddress); }
+    inline bool isUnknown() const { return pathname == 0; }
+  };
+
+  struct MapsLine;
+
+  /*
+   * /proc/[pid]/maps parsed into compact entries with interned pathnames,
+   * refresh reuses entries & strings so it doesn't allocate once warmed up
+   */
+  class ProcMapTable
+  {
+  private:
+    pid_t _pid;
+    std::vector<ProcMapEntry> _entries;
+    // id 0 is the empty pathname
+    std::deque<std::string> _strings;
+    std::unordered_map<std::string_view, uint32_t> _stringIds;
+
+    uint32_t intern(std::string_view str);
+    void addEntry(const MapsLine &line);
+
+  public:
+    ProcMapTable();
+    explicit ProcMapTable(pid_t pid);
+
+    ProcMapTable(const ProcMapTable &) = delete;
+    ProcMapTable &operator=(const ProcMapTable &) = delete;
+    ProcMapTable(ProcMapTable &&) = default;
+    ProcMapTable &operator=(ProcMapTable &&) = default;
+
+    /*
+     * Reparse maps file of pid
+     */
+    bool refresh();
+
+    /*
+     * Parse maps content read by readMapsFile
+     */
+    bool refresh(const std::string &rawMaps);
+
+    inline pid_t pid() const { return _pid; }
+
+    inline const std::vector<ProcMapEntry> &entries() const { return _entries; }
+
+    inline size_t size() const { return _entries.size(); }
+
+    inline const std::string &pathname(uint32_t id) const { return id < _strings.size() ? _strings[id] : _strings[0]; }
+
+    inline const std::string &pathname(const ProcMapEntry &entry) const { return pathname(entry.pathname); }
+
+    ProcMap toProcMap(const ProcMapEntry &entry) const;
+  };
+
   /*
    * reads /proc/[pid]/cmdline
    */
@@ -38,11 +110,77 @@ namespace KittyMemoryEx
    */
   pid_t getProcessID(const std::string &processName);
 
+  enum EProcessMatch
+  {
+    EK_PROC_MATCH_EXACT = 0,
+    EK_PROC_MATCH_PREFIX,
+    // ECMAScript regex searched in process name
+    EK_PROC_MATCH_REGEX
+  };
+
+  struct ProcessInfo
+  {
+    pid_t pid;
+    // clock ticks since boot, tells apart processes reusing the same pid
+    unsigned long long startTime;
+    // first argument of cmdline, comm for processes with empty cmdline
+    std::string name;
+    std::string comm;
+    // pidfd_open handle if requested, -1 otherwise, owned by caller
+    int pidfd;
+
+    ProcessInfo() : pid(0), startTime(0), pidfd(-1) {}
+  };
+
+  /*
+   * Opens a pidfd of pid, -1 if not supported by kernel
+   */
+  int openPidfd(pid_t pid);
+
+  /*
+   * Process lookup by name over /proc, processes are cached by pid & /proc/[pid] inode,
+   * cmdline is read on every lookup so renamed or exec'd processes are seen,
+   * stat is only read for new or renamed matches
+   */
+  class ProcessFinder
+  {
+  private:
+    struct CachedProcess
+    {
+      // inode of /proc/[pid] from readdir, a reused pid gets a new one
+      ino_t inode;
+      unsigned long long startTime;
+      std::string name, comm;
+      // name taken from comm as cmdline was empty
+      bool fromComm;
+    };
+    std::unordered_map<pid_t, CachedProcess> _cache;
+
+  public:
+    /*
+     * Find all processes matching name
+     * @param openPidfds: open a pidfd for each result, results whose pid got reused meanwhile are dropped
+     */
+    std::vector<ProcessInfo> find(const std::string &name, EProcessMatch match = EK_PROC_MATCH_EXACT, bool openPidfds = false);
+
+    /*
+     * First process matching name, 0 if not found
+     */
+    pid_t findFirst(const std::string &name, EProcessMatch match = EK_PROC_MATCH_EXACT);
+
+    inline void clearCache() { _cache.clear(); }
+  };
+
   /*
    * Gets integer variable from /proc/[pid]/status
    */
   int getStatusInteger(pid_t pid, const std::string &var);
 
+  /*
+   * Reads raw content of /proc/[pid]/maps into buffer, reuses buffer capacity
+   */
+  bool readMapsFile(pid_t pid, std::string &buffer);
+
   /*
    * Gets info of all maps in /proc/[pid]/maps
    */
@@ -67,4 +205,56 @@ namespace KittyMemoryEx
    * Gets map info of an address in /proc/[pid]/maps
    */
   ProcMap getAddressMap(pid_t pid, uintptr_t address);
+
+  /*
+   * Parsed /proc/[pid]/maps kept sorted by address with a pathname index,
+   * lookups don't reparse the maps file until refresh is called
+   */
+  class ProcMapSnapshot
+  {
+  private:
+    pid_t _pid;
+    std::vector<ProcMap> _maps;
+    // pathname -> indexes of its maps in address order
+    std::unordered_map<std::string, std::vector<size_t>> _pathIndex;
+
+    std::vector<ProcMap> collect(const std::function<bool(const std::string &)> &matchPath) const;
+
+  public:
+    ProcMapSnapshot() : _pid(0) {}
+    explicit ProcMapSnapshot(pid_t pid) : _pid(pid) { refresh(); }
+
+    /*
+     * Reparse maps file of pid
+     */
+    bool refresh();
+
+    inline pid_t pid() const { return _pid; }
+
+    inline bool empty() const { return _maps.empty(); }
+
+    inline size_t size() const { return _maps.size(); }
+
+    inline const std::vector<ProcMap> &maps() const { return _maps; }
+
+    /*
+     * Map containing address in O(log n)
+     */
+    ProcMap getAddressMap(uintptr_t address) const;
+
+    /*
+     * Maps which pathname equals name in O(1)
+     */
+    std::vector<ProcMap> getMapsEqual(const std::string &name) const;
+
+    /*
+     * Maps which pathname contains name, only unique pathnames are compared
+     */
+    std::vector<ProcMap> getMapsContain(const std::string &name) const;
+
+    /*
+     * Maps which pathname ends with name, only unique pathnames are compared
+     */
+    std::vector<ProcMap> getMapsEndWith(const std::string &name) const;
+  };
 }
@@ -94,6 +94,22 @@ size_t KittyMemoryMgr::writeMem(uintptr_t address, void *buffer, size_t len) con
     return _pMemOp->Write(address, buffer, len);
 }
 
+size_t KittyMemoryMgr::readMemBatch(std::vector<KittyMemRequest> &requests) const
+{
+    if (!isMemValid() || requests.empty())
+        return 0;
+
+    return _pMemOp->ReadBatch(requests.data(), requests.size());
+}
+
+size_t KittyMemoryMgr::writeMemBatch(std::vector<KittyMemRequest> &requests) const
+{
+    if (!isMemValid() || requests.empty())
+        return 0;
+
+    return _pMemOp->WriteBatch(requests.data(), requests.size());
+}
+
 std::string KittyMemoryMgr::readMemStr(uintptr_t address, size_t maxLen) const
 {
     if (!isMemValid() || !address || !maxLen)
@@ -102,6 +118,19 @@ std::string KittyMemoryMgr::readMemStr(uintptr_t address, size_t maxLen) const
     return _pMemOp->ReadStr(address, maxLen);
 }
 
+size_t KittyMemoryMgr::readMemStrBatch(const std::vector<uintptr_t> &addresses, size_t maxLen, std::vector<char> &arena,
+                                       std::vector<std::string_view> &strings) const
+{
+    if (!isMemValid() || !maxLen)
+    {
+        arena.clear();
+        strings.assign(addresses.size(), std::string_view());
+        return 0;
+    }
+
+    return _pMemOp->ReadStrBatch(addresses, maxLen, arena, strings);
+}
+
 bool KittyMemoryMgr::writeMemStr(uintptr_t address, std::string str) const
 {
     if (!isMemValid() || !address || str.empty())
@@ -120,6 +149,14 @@ bool KittyMemoryMgr::isValidELF(uintptr_t elfBase) const
 }
 
 ElfBaseMap KittyMemoryMgr::getElfBaseMap(const std::string &elfName) const
+{
+    if (!isMemValid() || elfName.empty())
+        return ElfBaseMap{};
+
+    return getElfBaseMap(elfName, KittyMemoryEx::ProcMapSnapshot(_pid));
+}
+
+ElfBaseMap KittyMemoryMgr::getElfBaseMap(const std::string &elfName, const KittyMemoryEx::ProcMapSnapshot &maps) const
 {
     ElfBaseMap ret{};
 
@@ -128,8 +165,7 @@ ElfBaseMap KittyMemoryMgr::getElfBaseMap(const std::string &elfName) const
 
     std::vector<ElfBaseMap> elfMaps;
 
-    auto maps = KittyMemoryEx::getMapsContain(_pid, elfName);
-    for (auto &it : maps)
+    for (auto &it : maps.getMapsContain(elfName))
     {
         if (!isValidELF(it.startAddress))
             continue;
@@ -157,7 +193,7 @@ ElfBaseMap KittyMemoryMgr::getElfBaseMap(const std::string &elfName) const
 
     int nMostMaps = 0;
 
-    auto allMaps = KittyMemoryEx::getAllMaps(_pid);
+    const auto &allMaps = maps.maps();
     for (auto &currElf : elfMaps)
     {
         int numMaps = 0;
@@ -165,14 +201,10 @@ ElfBaseMap KittyMemoryMgr::getElfBaseMap(const std::string &elfName) const
         if (start >= end)
             continue;
 
-        for (auto &currMap : allMaps)
-        {
-            if (currMap.startAddress >= start && currMap.endAddress <= end)
-                numMaps++;
-
-            if (currMap.endAddress > end)
-                break;
-        }
+        auto currMap = std::lower_bound(allMaps.begin(), allMaps.end(), start, [](const ProcMap &m, uintptr_t a)
+                                        { return m.startAddress < a; });
+        for (; currMap != allMaps.end() && currMap->endAddress <= end; ++currMap)
+            numMaps++;
 
         if (numMaps > nMostMaps)
         {
@@ -221,12 +253,10 @@ bool KittyMemoryMgr::dumpMemRange(uintptr_t start, uintptr_t end, const std::str
         return false;
     }
 
-    char memPath[256] = {0};
-    snprintf(memPath, sizeof(memPath), "/proc/%d/mem", _pid);
-    KittyIOFile srcFile(memPath, O_RDONLY);
-    if (!srcFile.Open())
+    KittyMemIO srcMem;
+    if (!srcMem.init(_pid))
     {
-        KITTY_LOGE("dumpMemRange: Couldn't open mem file %s, error=%s", memPath, srcFile.lastStrError().c_str());
+        KITTY_LOGE("dumpMemRange: Couldn't initialize IO memory operation.");
         return false;
     }
 
@@ -254,7 +284,9 @@ bool KittyMemoryMgr::dumpMemRange(uintptr_t start, uintptr_t end, const std::str
 
     KITTY_LOGI("dumpMemRange: Dumping: [ %p - %p | Size: %zu%s ] ...", (void *)start, (void *)end, displaySize, units[u]);
 
-    size_t read_sz = srcFile.Read(start, dmmap, dumpSize);
+    // unreadable pages are skipped and zero filled
+    std::vector<bool> pages;
+    size_t read_sz = srcMem.ReadPages(start, dmmap, dumpSize, &pages);
     if (!read_sz)
     {
         KITTY_LOGE("dumpMemRange: failed to read memory range (%p - %p).", (void *)start, (void *)end);
@@ -263,7 +295,8 @@ bool KittyMemoryMgr::dumpMemRange(uintptr_t start, uintptr_t end, const std::str
     }
 
     if (read_sz != dumpSize)
-        KITTY_LOGW("dumpMemRange: dump size %zu but bytes read %zu. error=%s.", dumpSize, read_sz, srcFile.lastStrError().c_str());
+        KITTY_LOGW("dumpMemRange: dump size %zu but bytes read %zu, %zu unreadable pages zero filled.",
+                   dumpSize, read_sz, size_t(std::count(pages.begin(), pages.end(), false)));
 
     ssize_t write_sz = dstFile.Write(0, dmmap, dumpSize);
     if (write_sz <= 0)
@@ -316,4 +349,26 @@ bool KittyMemoryMgr::dumpMemELF(uintptr_t elfBase, const std::string &destinatio
 
     ElfScanner elf = elfScanner.createWithBase(elfBase);
     return elf.isValid() && dumpMemRange(elfBase, elfBase + elf.loadSize(), destination);
-}
\ No newline at end of file
+}
+
+KittyPointerScanner KittyMemoryMgr::createPointerScanner(const std::vector<std::string> &modules) const
+{
+    if (!isMemValid())
+        return KittyPointerScanner();
+
+    KittyPointerScanner scanner(_pMemOp.get());
+    KittyMemoryEx::ProcMapSnapshot maps(_pid);
+    for (auto &it : modules)
+    {
+        auto elfBase = getElfBaseMap(it, maps);
+        if (!elfBase.isValid())
+        {
+            KITTY_LOGW("createPointerScanner: couldn't find ELF base of %s.", it.c_str());
+            continue;
+        }
+
+        const uintptr_t start = elfBase.map.startAddress;
+        scanner.addModule(KittyUtils::fileNameFromPath(elfBase.map.pathname), start, start + elfBase.elfScan.loadSize());
+    }
+    return scanner;
+}
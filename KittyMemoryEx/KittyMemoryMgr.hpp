@@ -4,9 +4,16 @@
 #include "KittyIOFile.hpp"
 #include "KittyMemoryEx.hpp"
 #include "KittyMemOp.hpp"
+#include "KittyMemCache.hpp"
+#include "KittyMemReadAhead.hpp"
+#include "KittyMemLayout.hpp"
 #include "MemoryPatch.hpp"
 #include "MemoryBackup.hpp"
+#include "KittyPattern.hpp"
 #include "KittyScanner.hpp"
+#include "KittyValueScanner.hpp"
+#include "KittyPointerScanner.hpp"
+#include "KittyMapWatcher.hpp"
 #include "KittyTrace.hpp"
 
 using KittyMemoryEx::ProcMap;
@@ -52,6 +59,11 @@ public:
 
     inline bool isMemValid() const { return _init && _pid && _pMemOp.get(); }
 
+    /**
+     * Memory operation used for reads & writes, e.g. to wrap it in a KittyMemCache
+     */
+    inline IKittyMemOp *memOp() const { return _pMemOp.get(); }
+
     /**
      * Read remote memory
      */
@@ -62,11 +74,114 @@ public:
      */
     size_t writeMem(uintptr_t address, void *buffer, size_t len) const;
 
+    /**
+     * Read multiple remote ranges with as few syscalls as possible
+     * @return total bytes read, bytes of each request is set
+     */
+    size_t readMemBatch(std::vector<KittyMemRequest> &requests) const;
+
+    /**
+     * Write multiple remote ranges with as few syscalls as possible
+     * @return total bytes written, bytes of each request is set
+     */
+    size_t writeMemBatch(std::vector<KittyMemRequest> &requests) const;
+
+    /**
+     * Read remote value of T
+     * @return true if all sizeof(T) bytes were read
+     */
+    template <typename T>
+    bool read(uintptr_t address, T &value) const
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "read type must be trivially copyable");
+        return readMem(address, &value, sizeof(T)) == sizeof(T);
+    }
+
+    /**
+     * Read remote value of T, value initialized T if not fully read
+     */
+    template <typename T>
+    T read(uintptr_t address) const
+    {
+        T value{};
+        if (!read(address, value))
+            value = T{};
+        return value;
+    }
+
+    /**
+     * Read count contiguous remote values of T in one read
+     * @return number of fully read values
+     */
+    template <typename T>
+    size_t readArray(uintptr_t address, T *values, size_t count) const
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "read type must be trivially copyable");
+        if (!values || !count)
+            return 0;
+
+        return readMem(address, values, count * sizeof(T)) / sizeof(T);
+    }
+
+    /**
+     * Read count contiguous remote values of T in one read, result is cut to fully read values
+     */
+    template <typename T>
+    std::vector<T> readArray(uintptr_t address, size_t count) const
+    {
+        std::vector<T> values(count);
+        values.resize(readArray(address, values.data(), count));
+        return values;
+    }
+
+    /**
+     * Write remote value of T
+     * @return true if all sizeof(T) bytes were written
+     */
+    template <typename T>
+    bool write(uintptr_t address, const T &value) const
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "write type must be trivially copyable");
+        T copy = value;
+        return writeMem(address, &copy, sizeof(T)) == sizeof(T);
+    }
+
+    /**
+     * Read fields of a KittyLayout from remote struct at base with one batched read
+     * @return true if every field was fully read
+     */
+    template <typename Layout>
+    bool readLayout(uintptr_t base, typename Layout::type &out) const
+    {
+        return isMemValid() && Layout::read(_pMemOp.get(), base, out);
+    }
+
+    /**
+     * Read fields of a KittyLayout from many remote structs with one batched read
+     * @param out: resized to bases count
+     * @param valid: optional, receives whether each struct was fully read
+     * @return number of fully read structs
+     */
+    template <typename Layout>
+    size_t readLayoutBatch(const std::vector<uintptr_t> &bases, std::vector<typename Layout::type> &out,
+                           std::vector<bool> *valid = nullptr) const
+    {
+        return Layout::readBatch(isMemValid() ? _pMemOp.get() : nullptr, bases, out, valid);
+    }
+
     /**
      * Read string from remote memory
      */
     std::string readMemStr(uintptr_t address, size_t maxLen) const;
 
+    /**
+     * Read many strings from remote memory with a few batched reads
+     * @param arena: receives string bytes, views in strings point into it
+     * @return total length of read strings
+     */
+    size_t readMemStrBatch(const std::vector<uintptr_t> &addresses, size_t maxLen, std::vector<char> &arena,
+                           std::vector<std::string_view> &strings) const;
+
     /**
      * Write string to remote memory
      */
@@ -83,6 +198,12 @@ public:
      */
     ElfBaseMap getElfBaseMap(const std::string &elfName) const;
 
+    /**
+     * Find base map of a loaded ELF with name using an existing maps snapshot,
+     * reuse one snapshot to resolve many ELFs without reparsing maps
+     */
+    ElfBaseMap getElfBaseMap(const std::string &elfName, const KittyMemoryEx::ProcMapSnapshot &maps) const;
+
     /**
      * Find remote address of local function / variable
     */
@@ -102,4 +223,28 @@ public:
      * Dump remote memory loaded ELF
      */
     bool dumpMemELF(uintptr_t elfBase, const std::string &destination) const;
+
+    /**
+     * Create a value scanner using this process memory operation
+     * @param type: scanned value type
+     * @param alignment: slot alignment, 0 for value size
+     */
+    inline KittyValueScanner createValueScanner(EKittyValueType type, size_t alignment = 0) const
+    {
+        return KittyValueScanner(_pMemOp.get(), type, alignment);
+    }
+
+    /**
+     * Create a pointer scanner with base maps of ELF modules as chain starts, index is not built
+     * @param modules: ELF names passed to getElfBaseMap
+     */
+    KittyPointerScanner createPointerScanner(const std::vector<std::string> &modules) const;
+
+    /**
+     * Create a pointer chain resolver using this process memory operation
+     */
+    inline KittyPointerResolver createPointerResolver() const
+    {
+        return KittyPointerResolver(_pMemOp.get());
+    }
 };
\ No newline at end of file
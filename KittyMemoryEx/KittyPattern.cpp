@@ -0,0 +1,309 @@
+#include "KittyPattern.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#include <immintrin.h>
+#define KT_SCAN_SSE2
+#define KT_SCAN_AVX2
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define KT_SCAN_NEON
+#endif
+
+// refs
+// https://github.com/learn-more/findpattern-bench
+// http://0x80.pl/articles/simd-strfind.html
+
+// rough frequency rank of bytes in x86 / arm code and data, higher is more common
+static int byteFrequencyRank(uint8_t b)
+{
+    static const uint8_t common[] = {
+        0x00, 0xFF, 0x48, 0x8B, 0x89, 0x0F, 0x01, 0xE8, 0x24, 0x4C, 0x8D, 0x85,
+        0xF9, 0x91, 0xE0, 0x03, 0xD6, 0x52, 0xB9, 0x94, 0x97, 0xA9, 0xFD, 0x7B,
+        0x1F, 0xD5, 0x02, 0x08, 0x10, 0x04, 0x83, 0xC0, 0x20, 0x40, 0x80, 0x74,
+        0x75, 0xC3, 0xCC, 0x90, 0x41, 0x44, 0x45, 0x49, 0x8A, 0xE9, 0x05, 0x06};
+
+    for (size_t i = 0; i < sizeof(common); i++)
+    {
+        if (common[i] == b)
+            return int(sizeof(common) - i);
+    }
+    return 0;
+}
+
+static int hexNibble(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+KittyPattern::KittyPattern(const void *bytes, const std::string &mask) : KittyPattern()
+{
+    if (!bytes || mask.empty())
+        return;
+
+    const size_t size = mask.length();
+    _bytes.resize(size);
+    _mask.resize(size);
+
+    for (size_t i = 0; i < size; i++)
+    {
+        if (mask[i] != 'x')
+            continue;
+
+        _mask[i] = 0xFF;
+        _bytes[i] = ((const uint8_t *)bytes)[i];
+    }
+
+    compile();
+}
+
+KittyPattern::KittyPattern(const void *bytes, const uint8_t *mask, size_t size) : KittyPattern()
+{
+    if (!bytes || !mask || !size)
+        return;
+
+    _bytes.resize(size);
+    _mask.assign(mask, mask + size);
+
+    for (size_t i = 0; i < size; i++)
+        _bytes[i] = ((const uint8_t *)bytes)[i] & _mask[i];
+
+    compile();
+}
+
+KittyPattern KittyPattern::fromIDA(const std::string &ida)
+{
+    KittyPattern pattern;
+
+    std::vector<uint8_t> bytes, mask;
+    bytes.reserve(ida.length() / 2);
+    mask.reserve(ida.length() / 2);
+
+    bool valid = parseIDA(ida.c_str(), ida.length(), [&](uint8_t b, uint8_t m)
+                          { bytes.push_back(b), mask.push_back(m); });
+    if (!valid)
+    {
+        KITTY_LOGE("KittyPattern: invalid IDA pattern \"%s\".", ida.c_str());
+        return pattern;
+    }
+
+    pattern._bytes = std::move(bytes);
+    pattern._mask = std::move(mask);
+    pattern.compile();
+    return pattern;
+}
+
+KittyPattern KittyPattern::fromHex(std::string hex, const std::string &mask)
+{
+    if (mask.empty() || !KittyUtils::validateHexString(hex) || (hex.length() / 2) != mask.length())
+        return KittyPattern();
+
+    std::vector<uint8_t> bytes(mask.length());
+    for (size_t i = 0; i < bytes.size(); i++)
+        bytes[i] = uint8_t((hexNibble(hex[i * 2]) << 4) | hexNibble(hex[(i * 2) + 1]));
+
+    return KittyPattern(bytes.data(), mask);
+}
+
+KittyPattern KittyPattern::fromData(const void *data, size_t size)
+{
+    if (!data || !size)
+        return KittyPattern();
+
+    std::vector<uint8_t> mask(size, 0xFF);
+    return KittyPattern(data, mask.data(), size);
+}
+
+void KittyPattern::compile()
+{
+    const size_t size = _bytes.size();
+
+    _hasAnchor = false;
+    _anchor1 = _anchor2 = 0;
+
+    int rank1 = INT32_MAX, rank2 = INT32_MAX;
+    for (size_t i = 0; i < size; i++)
+    {
+        if (_mask[i] != 0xFF)
+            continue;
+
+        int rank = byteFrequencyRank(_bytes[i]);
+        if (rank < rank1)
+        {
+            _anchor2 = _anchor1, rank2 = rank1;
+            _anchor1 = i, rank1 = rank;
+        }
+        else if (rank < rank2)
+        {
+            _anchor2 = i, rank2 = rank;
+        }
+    }
+
+    _hasAnchor = rank1 != INT32_MAX;
+    if (rank2 == INT32_MAX)
+        _anchor2 = _anchor1;
+
+    // horspool shifts, a wildcard matches every byte so it limits all shifts
+    size_t defaultSkip = size;
+    for (size_t i = 0; i + 1 < size; i++)
+    {
+        if (_mask[i] != 0xFF)
+            defaultSkip = size - 1 - i;
+    }
+
+    for (size_t c = 0; c < 256; c++)
+        _skip[c] = defaultSkip;
+
+    _defaultSkip = defaultSkip;
+    for (size_t i = 0; i + 1 < size; i++)
+    {
+        if (_mask[i] == 0xFF && (size - 1 - i) < _skip[_bytes[i]])
+            _skip[_bytes[i]] = size - 1 - i;
+    }
+}
+
+#define KT_SCAN_VERIFY_BITS(bits)           \
+    while (bits)                            \
+    {                                       \
+        size_t k = i + __builtin_ctz(bits); \
+        if (pat.matches(data + k))          \
+            return k;                       \
+        bits &= bits - 1;                   \
+    }
+
+static size_t findScalar(const uint8_t *data, size_t i, size_t last, const KittyPattern &pat)
+{
+    const size_t size = pat.size();
+
+    // long patterns without trailing wildcards, horspool skips most bytes
+    if (pat.defaultSkip() >= 8 && pat.mask()[size - 1] == 0xFF)
+    {
+        while (i <= last)
+        {
+            const uint8_t c = data[i + size - 1];
+            if (c == pat.bytes()[size - 1] && pat.matches(data + i))
+                return i;
+
+            i += pat.skip(c);
+        }
+        return KittyPattern::npos;
+    }
+
+    const size_t a1 = pat.anchor(), a2 = pat.secondAnchor();
+    const uint8_t b1 = pat.bytes()[a1], b2 = pat.bytes()[a2];
+    for (; i <= last; i++)
+    {
+        const uint8_t *found = (const uint8_t *)memchr(data + i + a1, b1, last - i + 1);
+        if (!found)
+            break;
+
+        i = size_t(found - data) - a1;
+        if (data[i + a2] == b2 && pat.matches(data + i))
+            return i;
+    }
+    return KittyPattern::npos;
+}
+
+#ifdef KT_SCAN_SSE2
+static size_t findSSE2(const uint8_t *data, size_t i, size_t last, const KittyPattern &pat)
+{
+    const size_t a1 = pat.anchor(), a2 = pat.secondAnchor();
+    const __m128i first = _mm_set1_epi8(char(pat.bytes()[a1]));
+    const __m128i second = _mm_set1_epi8(char(pat.bytes()[a2]));
+
+    for (; i + 15 <= last; i += 16)
+    {
+        const __m128i block1 = _mm_loadu_si128((const __m128i *)(data + i + a1));
+        const __m128i block2 = _mm_loadu_si128((const __m128i *)(data + i + a2));
+        const __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(first, block1), _mm_cmpeq_epi8(second, block2));
+
+        uint32_t bits = uint32_t(_mm_movemask_epi8(eq));
+        KT_SCAN_VERIFY_BITS(bits)
+    }
+
+    return findScalar(data, i, last, pat);
+}
+#endif
+
+#ifdef KT_SCAN_AVX2
+__attribute__((target("avx2"))) static size_t findAVX2(const uint8_t *data, size_t i, size_t last, const KittyPattern &pat)
+{
+    const size_t a1 = pat.anchor(), a2 = pat.secondAnchor();
+    const __m256i first = _mm256_set1_epi8(char(pat.bytes()[a1]));
+    const __m256i second = _mm256_set1_epi8(char(pat.bytes()[a2]));
+
+    for (; i + 31 <= last; i += 32)
+    {
+        const __m256i block1 = _mm256_loadu_si256((const __m256i *)(data + i + a1));
+        const __m256i block2 = _mm256_loadu_si256((const __m256i *)(data + i + a2));
+        const __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(first, block1), _mm256_cmpeq_epi8(second, block2));
+
+        uint32_t bits = uint32_t(_mm256_movemask_epi8(eq));
+        KT_SCAN_VERIFY_BITS(bits)
+    }
+
+    return findSSE2(data, i, last, pat);
+}
+
+static bool hasAVX2()
+{
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#endif
+
+#ifdef KT_SCAN_NEON
+static size_t findNEON(const uint8_t *data, size_t i, size_t last, const KittyPattern &pat)
+{
+    const size_t a1 = pat.anchor(), a2 = pat.secondAnchor();
+    const uint8x16_t first = vdupq_n_u8(pat.bytes()[a1]);
+    const uint8x16_t second = vdupq_n_u8(pat.bytes()[a2]);
+
+    for (; i + 15 <= last; i += 16)
+    {
+        const uint8x16_t block1 = vld1q_u8(data + i + a1);
+        const uint8x16_t block2 = vld1q_u8(data + i + a2);
+        const uint8x16_t eq = vandq_u8(vceqq_u8(first, block1), vceqq_u8(second, block2));
+
+        // narrow to 4 bits per byte, keep one bit per byte
+        uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        bits &= 0x8888888888888888ull;
+        while (bits)
+        {
+            size_t k = i + (__builtin_ctzll(bits) / 4);
+            if (pat.matches(data + k))
+                return k;
+            bits &= bits - 1;
+        }
+    }
+
+    return findScalar(data, i, last, pat);
+}
+#endif
+
+size_t KittyPattern::find(const uint8_t *data, size_t size, size_t offset) const
+{
+    if (!data || !isValid() || size < _bytes.size() || offset > size - _bytes.size())
+        return npos;
+
+    // all wildcards
+    if (!_hasAnchor)
+        return offset;
+
+    const size_t last = size - _bytes.size();
+
+#if defined(KT_SCAN_AVX2)
+    if (hasAVX2())
+        return findAVX2(data, offset, last, *this);
+    return findSSE2(data, offset, last, *this);
+#elif defined(KT_SCAN_NEON)
+    return findNEON(data, offset, last, *this);
+#else
+    return findScalar(data, offset, last, *this);
+#endif
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "KittyUtils.hpp"
+
+#include <stdexcept>
+
+template <size_t N>
+struct KittyPatternLiteral;
+
+/**
+ * Precompiled masked byte pattern, parse it once and reuse it for every scan.
+ * Wildcard bytes are zero in both bytes and mask.
+ */
+class KittyPattern
+{
+private:
+    std::vector<uint8_t> _bytes, _mask;
+    // offsets of the two rarest fully masked bytes, used to find candidates
+    size_t _anchor1, _anchor2;
+    bool _hasAnchor;
+    // horspool bad character shift, indexed by the byte under the last pattern byte
+    size_t _skip[256];
+    // shift of bytes not in the pattern, the largest one
+    size_t _defaultSkip;
+
+    void compile();
+
+public:
+    static constexpr size_t npos = size_t(-1);
+
+    KittyPattern() : _anchor1(0), _anchor2(0), _hasAnchor(false), _skip{}, _defaultSkip(0) {}
+
+    /**
+     * @param bytes: pattern bytes
+     * @param mask: bytes mask x/?
+     */
+    KittyPattern(const void *bytes, const std::string &mask);
+
+    /**
+     * @param bytes: pattern bytes
+     * @param mask: per byte mask, 0 for wildcard
+     * @param size: pattern size
+     */
+    KittyPattern(const void *bytes, const uint8_t *mask, size_t size);
+
+    /**
+     * Pattern parsed at compile time
+     */
+    template <size_t N>
+    KittyPattern(const KittyPatternLiteral<N> &literal);
+
+    /**
+     * Parse IDA style signature "48 8B ?? ?? 89", '?' and '??' are wildcards
+     */
+    static KittyPattern fromIDA(const std::string &ida);
+
+    /**
+     * Parse hex string with x/? mask
+     */
+    static KittyPattern fromHex(std::string hex, const std::string &mask);
+
+    /**
+     * Exact data pattern
+     */
+    static KittyPattern fromData(const void *data, size_t size);
+
+    inline bool isValid() const { return !_bytes.empty() && _bytes.size() == _mask.size(); }
+
+    inline size_t size() const { return _bytes.size(); }
+
+    inline const std::vector<uint8_t> &bytes() const { return _bytes; }
+
+    inline const std::vector<uint8_t> &mask() const { return _mask; }
+
+    inline bool hasAnchor() const { return _hasAnchor; }
+
+    inline size_t anchor() const { return _anchor1; }
+
+    inline size_t secondAnchor() const { return _anchor2; }
+
+    inline size_t skip(uint8_t b) const { return _skip[b]; }
+
+    inline size_t defaultSkip() const { return _defaultSkip; }
+
+    inline bool matches(const uint8_t *data) const
+    {
+        const size_t n = _bytes.size();
+        for (size_t i = 0; i < n; i++)
+        {
+            if ((data[i] & _mask[i]) != _bytes[i])
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * Find first match in local data starting from offset
+     * @return match offset or npos
+     */
+    size_t find(const uint8_t *data, size_t size, size_t offset = 0) const;
+
+    /**
+     * Parse IDA style signature, calls emit(byte, mask) for each pattern byte
+     * @return false if signature is invalid
+     */
+    template <typename F>
+    static constexpr bool parseIDA(const char *ida, size_t len, F &&emit)
+    {
+        auto nibble = [](char c) -> int
+        {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return -1;
+        };
+        auto isSpace = [](char c)
+        { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+
+        size_t count = 0;
+        for (size_t i = 0; i < len && ida[i];)
+        {
+            if (isSpace(ida[i]))
+            {
+                i++;
+                continue;
+            }
+
+            if (ida[i] == '?')
+            {
+                // ? or ??
+                i += (i + 1 < len && ida[i + 1] == '?') ? 2 : 1;
+                emit(uint8_t(0), uint8_t(0));
+                count++;
+                continue;
+            }
+
+            if (i + 1 >= len)
+                return false;
+
+            int hi = nibble(ida[i]), lo = nibble(ida[i + 1]);
+            if (hi < 0 || lo < 0)
+                return false;
+
+            emit(uint8_t((hi << 4) | lo), uint8_t(0xFF));
+            count++;
+            i += 2;
+        }
+        return count > 0;
+    }
+};
+
+/**
+ * IDA style signature parsed at compile time, an invalid signature fails to compile
+ * constexpr KittyPatternLiteral sig("48 8B ?? ?? 89");
+ */
+template <size_t N>
+struct KittyPatternLiteral
+{
+    uint8_t bytes[N] = {};
+    uint8_t mask[N] = {};
+    size_t size = 0;
+
+    constexpr KittyPatternLiteral(const char (&ida)[N])
+    {
+        size_t n = 0;
+        // not a constant expression, constexpr literals stop compiling here
+        if (!KittyPattern::parseIDA(ida, N, [&](uint8_t b, uint8_t m)
+                                    { bytes[n] = b, mask[n] = m, n++; }))
+            throw std::invalid_argument("KittyPatternLiteral: invalid IDA signature");
+
+        size = n;
+    }
+};
+
+template <size_t N>
+KittyPattern::KittyPattern(const KittyPatternLiteral<N> &literal) : KittyPattern(literal.bytes, literal.mask, literal.size)
+{
+}
@@ -0,0 +1,358 @@
+#include "KittyPointerScanner.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+std::string KittyPointerChain::toString() const
+{
+    std::string str = KittyUtils::strfmt("%s+0x%llx", module.c_str(), (unsigned long long)baseOffset);
+    for (auto &it : offsets)
+        str += KittyUtils::strfmt(" -> 0x%llx", (unsigned long long)it);
+    return str;
+}
+
+std::shared_ptr<KittyThreadPool> KittyPointerScanner::threadPool() const
+{
+    return _threadPool ? _threadPool : KittyThreadPool::shared();
+}
+
+void KittyPointerScanner::addModule(const std::string &name, uintptr_t start, uintptr_t end)
+{
+    if (start >= end)
+        return;
+
+    KittyPointerModule module(name, start, end);
+    _modules.insert(std::upper_bound(_modules.begin(), _modules.end(), module, [](const KittyPointerModule &a, const KittyPointerModule &b)
+                                     { return a.start < b.start; }), module);
+}
+
+int KittyPointerScanner::findModule(uintptr_t address) const
+{
+    auto it = std::upper_bound(_modules.begin(), _modules.end(), address, [](uintptr_t a, const KittyPointerModule &m)
+                               { return a < m.start; });
+    if (it == _modules.begin())
+        return -1;
+
+    --it;
+    return it->contains(address) ? int(it - _modules.begin()) : -1;
+}
+
+void KittyPointerScanner::reset()
+{
+    _index = {};
+}
+
+bool KittyPointerScanner::buildIndex(const KittyMapFilter &filter)
+{
+    reset();
+
+    if (!_pMem)
+        return false;
+
+    const auto allMaps = KittyMemoryEx::getAllMaps(_pMem->remotePID());
+
+    // mapped ranges a value must point into, adjacent maps merged
+    std::vector<std::pair<uintptr_t, uintptr_t>> ranges;
+    for (auto &it : allMaps)
+    {
+        if (!ranges.empty() && ranges.back().second == it.startAddress)
+            ranges.back().second = it.endAddress;
+        else
+            ranges.emplace_back(it.startAddress, it.endAddress);
+    }
+
+    if (ranges.empty())
+        return false;
+
+    struct IndexItem
+    {
+        uintptr_t start, end;
+    };
+
+    const size_t itemSize = KT_SCAN_CHUNK_SIZE * 4;
+    std::vector<IndexItem> items;
+    for (auto &it : allMaps)
+    {
+        if (!filter.matches(it))
+            continue;
+
+        for (uintptr_t start = it.startAddress; start < it.endAddress; start += itemSize)
+            items.push_back({start, std::min<uintptr_t>(it.endAddress, start + itemSize)});
+    }
+
+    const uintptr_t lowest = ranges.front().first, highest = ranges.back().second;
+    const size_t pageSize = KT_PAGE_SIZE;
+
+    auto pool = threadPool();
+
+    // each item is sorted by its worker, sorted runs are merged after
+    std::vector<std::vector<IndexEntry>> itemEntries(items.size());
+    pool->run(items.size(), [&](size_t i)
+    {
+        const IndexItem &item = items[i];
+        auto &entries = itemEntries[i];
+
+        std::vector<uint8_t> buf(item.end - item.start);
+        std::vector<bool> valid;
+        _pMem->ReadPages(item.start, buf.data(), buf.size(), allMaps, &valid);
+
+        size_t lastRange = 0;
+        for (size_t page = 0; page < valid.size(); page++)
+        {
+            if (!valid[page])
+                continue;
+
+            const uint8_t *data = buf.data() + (page * pageSize);
+            for (size_t offset = 0; offset + sizeof(uintptr_t) <= pageSize; offset += sizeof(uintptr_t))
+            {
+                uintptr_t value;
+                memcpy(&value, data + offset, sizeof(uintptr_t));
+                if (value < lowest || value >= highest)
+                    continue;
+
+                // neighbouring pointers usually share a region
+                if (value < ranges[lastRange].first || value >= ranges[lastRange].second)
+                {
+                    auto it = std::upper_bound(ranges.begin(), ranges.end(), value, [](uintptr_t v, const std::pair<uintptr_t, uintptr_t> &r)
+                                               { return v < r.first; });
+                    --it;
+                    if (value >= it->second)
+                        continue;
+
+                    lastRange = size_t(it - ranges.begin());
+                }
+
+                entries.push_back({value, item.start + (page * pageSize) + offset});
+            }
+        }
+
+        std::sort(entries.begin(), entries.end());
+    });
+
+    std::vector<size_t> bounds(1, 0);
+    size_t total = 0;
+    for (auto &it : itemEntries)
+        bounds.push_back(total += it.size());
+
+    _index.reserve(total);
+    for (auto &it : itemEntries)
+    {
+        _index.insert(_index.end(), it.begin(), it.end());
+        it = {};
+    }
+
+    // merge sorted runs pairwise, each round in parallel
+    const size_t runs = itemEntries.size();
+    for (size_t width = 1; width < runs; width *= 2)
+    {
+        const size_t pairs = (runs + (2 * width) - 1) / (2 * width);
+        pool->run(pairs, [&](size_t p)
+        {
+            const size_t a = p * 2 * width, m = std::min(a + width, runs), b = std::min(a + (2 * width), runs);
+            if (m < b)
+                std::inplace_merge(_index.begin() + bounds[a], _index.begin() + bounds[m], _index.begin() + bounds[b]);
+        });
+    }
+
+    return !_index.empty();
+}
+
+std::vector<KittyPointerChain> KittyPointerScanner::findChains(uintptr_t target, size_t maxDepth, size_t maxOffset, size_t maxResults) const
+{
+    std::vector<KittyPointerChain> chains;
+
+    if (_index.empty() || _modules.empty() || !maxDepth || !maxResults)
+        return chains;
+
+    // backward bfs from target, a node is an address holding a pointer near its child nodes,
+    // edges of non static nodes only go one level down so every path ends at the target
+    struct Node
+    {
+        uintptr_t address;
+        size_t level;
+        int module;
+        std::vector<std::pair<size_t, uintptr_t>> edges;
+    };
+
+    std::vector<Node> nodes;
+    std::unordered_map<uintptr_t, size_t> nodeIds;
+    std::vector<size_t> frontier, next, statics;
+
+    nodes.push_back({target, 0, -1, {}});
+    nodeIds[target] = 0;
+    frontier.push_back(0);
+
+    for (size_t level = 1; level <= maxDepth && !frontier.empty(); level++)
+    {
+        next.clear();
+        for (size_t child : frontier)
+        {
+            const uintptr_t childAddress = nodes[child].address;
+            const uintptr_t lowest = childAddress > maxOffset ? childAddress - maxOffset : 0;
+
+            auto it = std::lower_bound(_index.begin(), _index.end(), IndexEntry{lowest, 0});
+            for (; it != _index.end() && it->value <= childAddress; ++it)
+            {
+                size_t id = 0;
+                auto found = nodeIds.find(it->address);
+                if (found == nodeIds.end())
+                {
+                    id = nodes.size();
+                    nodes.push_back({it->address, level, findModule(it->address), {}});
+                    nodeIds.emplace(it->address, id);
+
+                    // chains stop at the first static address
+                    if (nodes[id].module >= 0)
+                        statics.push_back(id);
+                    else
+                        next.push_back(id);
+                }
+                else
+                {
+                    // statics are never expanded so they can't form cycles and keep edges of every level,
+                    // other addresses keep their shortest distance
+                    id = found->second;
+                    if (nodes[id].module < 0 && nodes[id].level != level)
+                        continue;
+                }
+
+                nodes[id].edges.emplace_back(child, childAddress - it->value);
+            }
+        }
+        frontier.swap(next);
+    }
+
+    // chains through a non static node have its level as length
+    KittyPointerChain chain;
+    std::function<void(size_t)> walk = [&](size_t id)
+    {
+        for (auto &edge : nodes[id].edges)
+        {
+            if (chains.size() >= maxResults)
+                return;
+
+            chain.offsets.push_back(edge.second);
+            if (edge.first == 0)
+                chains.push_back(chain);
+            else
+                walk(edge.first);
+            chain.offsets.pop_back();
+        }
+    };
+
+    // shortest chains first
+    for (size_t depth = 1; depth <= maxDepth && chains.size() < maxResults; depth++)
+    {
+        for (size_t id : statics)
+        {
+            const KittyPointerModule &module = _modules[nodes[id].module];
+            chain.module = module.name;
+            chain.moduleBase = module.start;
+            chain.baseOffset = nodes[id].address - module.start;
+
+            for (auto &edge : nodes[id].edges)
+            {
+                if (chains.size() >= maxResults)
+                    break;
+
+                if (nodes[edge.first].level != depth - 1)
+                    continue;
+
+                chain.offsets.assign(1, edge.second);
+                if (edge.first == 0)
+                    chains.push_back(chain);
+                else
+                    walk(edge.first);
+            }
+        }
+    }
+
+    return chains;
+}
+
+size_t KittyPointerResolver::add(uintptr_t base, const std::vector<uintptr_t> &offsets)
+{
+    _chains.push_back({base, _offsets.size(), offsets.size()});
+    _offsets.insert(_offsets.end(), offsets.begin(), offsets.end());
+    _maxDepth = std::max(_maxDepth, offsets.size());
+    _results.emplace_back();
+    return _chains.size() - 1;
+}
+
+size_t KittyPointerResolver::resolve()
+{
+    _results.assign(_chains.size(), KittyChainResult());
+    _active.clear();
+
+    if (!_pMem)
+        return 0;
+
+    size_t resolved = 0;
+    for (size_t i = 0; i < _chains.size(); i++)
+    {
+        _results[i].address = _chains[i].start;
+        if (_chains[i].depth)
+        {
+            _active.push_back(i);
+        }
+        else
+        {
+            _results[i].status = EK_CHAIN_OK;
+            resolved++;
+        }
+    }
+
+    // one batched read per level for all chains still going
+    for (size_t level = 0; level < _maxDepth && !_active.empty(); level++)
+    {
+        _values.resize(_active.size());
+        _requests.resize(_active.size());
+        for (size_t k = 0; k < _active.size(); k++)
+            _requests[k] = KittyMemRequest(_results[_active[k]].address, &_values[k], sizeof(uintptr_t));
+
+        _pMem->ReadBatch(_requests.data(), _requests.size());
+
+        size_t kept = 0;
+        for (size_t k = 0; k < _active.size(); k++)
+        {
+            const size_t id = _active[k];
+            const Chain &chain = _chains[id];
+            KittyChainResult &result = _results[id];
+            result.level = level;
+
+            if (_requests[k].bytes != sizeof(uintptr_t))
+            {
+                result.status = EK_CHAIN_UNREADABLE;
+                continue;
+            }
+
+            if (!_values[k])
+            {
+                result.status = EK_CHAIN_NULL;
+                continue;
+            }
+
+            result.address = _values[k] + _offsets[chain.first + level];
+            if (level + 1 == chain.depth)
+            {
+                result.status = EK_CHAIN_OK;
+                result.level = chain.depth;
+                resolved++;
+                continue;
+            }
+
+            _active[kept++] = id;
+        }
+        _active.resize(kept);
+    }
+
+    return resolved;
+}
+
+void KittyPointerResolver::clear()
+{
+    _chains.clear();
+    _offsets.clear();
+    _results.clear();
+    _maxDepth = 0;
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include "KittyUtils.hpp"
+#include "KittyMemoryEx.hpp"
+#include "KittyMemOp.hpp"
+#include "KittyScanner.hpp"
+
+/**
+ * Static region a pointer chain can start from, usually a loaded ELF
+ */
+struct KittyPointerModule
+{
+    std::string name;
+    uintptr_t start, end;
+
+    KittyPointerModule() : start(0), end(0) {}
+    KittyPointerModule(const std::string &name, uintptr_t start, uintptr_t end) : name(name), start(start), end(end) {}
+
+    inline bool contains(uintptr_t address) const { return address >= start && address < end; }
+};
+
+/**
+ * [[module + baseOffset] + offsets[0]] ... + offsets[n-1] == target
+ */
+struct KittyPointerChain
+{
+    std::string module;
+    uintptr_t moduleBase;
+    uintptr_t baseOffset;
+    std::vector<uintptr_t> offsets;
+
+    KittyPointerChain() : moduleBase(0), baseOffset(0) {}
+
+    inline size_t depth() const { return offsets.size(); }
+
+    /**
+     * "module+0x1234 -> 0x10 -> 0x8"
+     */
+    std::string toString() const;
+};
+
+enum EKittyChainStatus
+{
+    EK_CHAIN_OK = 0,
+    // pointer of failed level couldn't be read
+    EK_CHAIN_UNREADABLE,
+    // pointer of failed level is null
+    EK_CHAIN_NULL,
+    // chain not resolved yet
+    EK_CHAIN_PENDING
+};
+
+struct KittyChainResult
+{
+    EKittyChainStatus status;
+    // final address if resolved, otherwise address of the pointer that failed
+    uintptr_t address;
+    // dereference that failed starting from 0, depth if resolved
+    size_t level;
+
+    KittyChainResult() : status(EK_CHAIN_PENDING), address(0), level(0) {}
+
+    inline bool isValid() const { return status == EK_CHAIN_OK; }
+};
+
+/**
+ * Set of pointer chains compiled once & resolved together.
+ *
+ * Each resolve advances every unfinished chain by one dereference per ReadBatch,
+ * so N chains of depth D cost D batched reads instead of N x D reads.
+ * Buffers are kept between resolves, resolving the same set again doesn't allocate.
+ */
+class KittyPointerResolver
+{
+private:
+    IKittyMemOp *_pMem;
+
+    struct Chain
+    {
+        uintptr_t start;
+        // range of chain offsets in _offsets
+        size_t first, depth;
+    };
+    std::vector<Chain> _chains;
+    std::vector<uintptr_t> _offsets;
+    size_t _maxDepth;
+
+    std::vector<KittyChainResult> _results;
+    // scratch buffers of resolve
+    std::vector<size_t> _active;
+    std::vector<uintptr_t> _values;
+    std::vector<KittyMemRequest> _requests;
+
+public:
+    KittyPointerResolver() : _pMem(nullptr), _maxDepth(0) {}
+    KittyPointerResolver(IKittyMemOp *pMem) : _pMem(pMem), _maxDepth(0) {}
+
+    /**
+     * Add chain [[base] + offsets[0]] ... + offsets[n-1]
+     * @return chain index in results
+     */
+    size_t add(uintptr_t base, const std::vector<uintptr_t> &offsets);
+
+    /**
+     * Add chain found by KittyPointerScanner
+     * @return chain index in results
+     */
+    inline size_t add(const KittyPointerChain &chain) { return add(chain.moduleBase + chain.baseOffset, chain.offsets); }
+
+    inline size_t size() const { return _chains.size(); }
+
+    inline size_t maxDepth() const { return _maxDepth; }
+
+    /**
+     * Resolve all chains with at most maxDepth batched reads
+     * @return number of resolved chains
+     */
+    size_t resolve();
+
+    /**
+     * Results of last resolve in chain add order
+     */
+    inline const std::vector<KittyChainResult> &results() const { return _results; }
+
+    inline const KittyChainResult &result(size_t index) const { return _results[index]; }
+
+    void clear();
+};
+
+/**
+ * Reverse pointer index of a process, finds static pointer paths from module bases to a target address.
+ *
+ * The index holds every aligned pointer sized value of the scanned maps that points into a mapped region,
+ * as a flat array sorted by value, so it is built once and reused for any number of targets.
+ */
+class KittyPointerScanner
+{
+private:
+    IKittyMemOp *_pMem;
+    std::shared_ptr<KittyThreadPool> _threadPool;
+    std::vector<KittyPointerModule> _modules;
+
+    struct IndexEntry
+    {
+        uintptr_t value;
+        uintptr_t address;
+
+        inline bool operator<(const IndexEntry &other) const
+        {
+            return value < other.value || (value == other.value && address < other.address);
+        }
+    };
+    std::vector<IndexEntry> _index;
+
+    std::shared_ptr<KittyThreadPool> threadPool() const;
+
+    // module index containing address or -1
+    int findModule(uintptr_t address) const;
+
+public:
+    KittyPointerScanner() : _pMem(nullptr) {}
+    KittyPointerScanner(IKittyMemOp *pMem) : _pMem(pMem) {}
+
+    /**
+     * Worker pool used to build the index, KittyThreadPool::shared() is used if not set
+     */
+    inline void setThreadPool(std::shared_ptr<KittyThreadPool> pool) { _threadPool = std::move(pool); }
+
+    /**
+     * Add a static region chains can start from
+     */
+    void addModule(const std::string &name, uintptr_t start, uintptr_t end);
+
+    inline const std::vector<KittyPointerModule> &modules() const { return _modules; }
+
+    /**
+     * Scan maps matching filter & rebuild the pointer index
+     * @return false if nothing could be indexed
+     */
+    bool buildIndex(const KittyMapFilter &filter = KittyMapFilter());
+
+    /**
+     * Number of indexed pointers
+     */
+    inline size_t indexSize() const { return _index.size(); }
+
+    /**
+     * Memory used by the index in bytes
+     */
+    inline size_t memoryUsage() const { return _index.capacity() * sizeof(IndexEntry); }
+
+    /**
+     * Find chains from added modules to target using the current index, shortest chains first.
+     * Chains end at the first module address found and each intermediate address is only used at its shortest depth.
+     *
+     * @param maxDepth: max number of dereferences
+     * @param maxOffset: max offset added to each dereferenced pointer
+     * @param maxResults: max chains returned
+     */
+    std::vector<KittyPointerChain> findChains(uintptr_t target, size_t maxDepth = 5, size_t maxOffset = 0x1000,
+                                              size_t maxResults = 1000) const;
+
+    void reset();
+};
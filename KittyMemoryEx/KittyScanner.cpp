@@ -1,147 +1,581 @@
 #include "KittyScanner.hpp"
 #include "KittyMemoryEx.hpp"
+#include "KittyIOFile.hpp"
 
-// refs
-// https://github.com/learn-more/findpattern-bench
+#include <future>
 
-static bool compare(const char *data, const char *pattern, const char *mask)
+// calls cb(runStart, runEnd) for each run of readable pages within [start, end)
+template <typename F>
+static void forEachValidRun(uintptr_t start, uintptr_t end, const std::vector<bool> &pages, F &&cb)
 {
-    for (; *mask; ++mask, ++data, ++pattern)
+    const uintptr_t pageSize = KT_PAGE_SIZE;
+    const uintptr_t firstPage = KT_PAGE_START(start);
+
+    size_t i = 0;
+    while (i < pages.size())
     {
-        if (*mask == 'x' && *data != *pattern)
-            return false;
+        if (!pages[i])
+        {
+            i++;
+            continue;
+        }
+
+        size_t j = i;
+        while (j < pages.size() && pages[j])
+            j++;
+
+        uintptr_t runStart = std::max<uintptr_t>(start, firstPage + (i * pageSize));
+        uintptr_t runEnd = std::min<uintptr_t>(end, firstPage + (j * pageSize));
+        if (runStart < runEnd && !cb(runStart, runEnd))
+            break;
+
+        i = j;
     }
-    return !*mask;
 }
 
-static uintptr_t findInRange(const uintptr_t start, const uintptr_t end,
-                             const char *pattern, const std::string &mask)
+bool KittyScannerMgr::streamRange(uintptr_t start, uintptr_t end, size_t overlap, const ScanRunCallback &cb,
+                                  const std::vector<KittyMemoryEx::ProcMap> *maps) const
 {
-    const size_t scan_size = mask.length();
+    if (!_pMem || start >= end)
+        return false;
 
-    if (scan_size < 1 || ((start + scan_size) > end))
-        return 0;
+    struct ScanWindow
+    {
+        uintptr_t start = 0, end = 0;
+        std::vector<char> buf;
+        std::vector<bool> pages;
+        size_t bytes = 0;
+    };
 
-    const size_t length = end - start;
+    const size_t windowSize = std::min<uintptr_t>(end - start, _chunkSize + overlap);
 
-    for (size_t i = 0; i < length; ++i)
+    // without given maps they are parsed once, on the first window that doesn't read fully
+    std::vector<KittyMemoryEx::ProcMap> parsedMaps;
+    auto readWindow = [this, windowSize, &maps, &parsedMaps](ScanWindow &w)
     {
-        const uintptr_t current_end = start + i + scan_size;
-        if (current_end > end)
+        if (w.buf.size() < windowSize)
+            w.buf.resize(windowSize);
+
+        const size_t len = w.end - w.start;
+        if (!maps)
+        {
+            w.bytes = _pMem->Read(w.start, &w.buf[0], len);
+            if (w.bytes == len)
+            {
+                w.pages.assign((KT_PAGE_END(w.end) - KT_PAGE_START(w.start)) / KT_PAGE_SIZE, true);
+                return;
+            }
+
+            parsedMaps = KittyMemoryEx::getAllMaps(_pMem->remotePID());
+            maps = &parsedMaps;
+        }
+
+        w.bytes = _pMem->ReadPages(w.start, &w.buf[0], len, *maps, &w.pages);
+    };
+
+    ScanWindow windows[2];
+    int curr = 0;
+
+    windows[curr].start = start;
+    windows[curr].end = start + windowSize;
+    readWindow(windows[curr]);
+
+    bool anyRead = false, stop = false;
+    std::future<void> pending;
+    while (true)
+    {
+        ScanWindow &w = windows[curr];
+        ScanWindow &next = windows[curr ^ 1];
+
+        const bool hasNext = w.end < end;
+        if (hasNext)
+        {
+            next.start = w.start + _chunkSize;
+            next.end = std::min<uintptr_t>(end, next.start + windowSize);
+            if (_doubleBuffering)
+                pending = std::async(std::launch::async, readWindow, std::ref(next));
+        }
+
+        // matches starting in the overlap are reported by the next window
+        const uintptr_t reportEnd = hasNext ? next.start : end;
+
+        anyRead |= w.bytes > 0;
+        forEachValidRun(w.start, w.end, w.pages, [&](uintptr_t runStart, uintptr_t runEnd)
+        {
+            if (runStart >= reportEnd)
+                return false;
+
+            size_t reportSize = std::min(runEnd, reportEnd) - runStart;
+            stop = !cb(runStart, w.buf.data() + (runStart - w.start), runEnd - runStart, reportSize);
+            return !stop;
+        });
+
+        if (stop || !hasNext)
             break;
 
-        if (!compare(reinterpret_cast<const char *>(start + i), pattern, mask.c_str()))
-            continue;
+        if (_doubleBuffering)
+            pending.get();
+        else
+            readWindow(next);
 
-        return start + i;
+        curr ^= 1;
     }
-    return 0;
+
+    if (pending.valid())
+        pending.wait();
+
+    return anyRead;
 }
 
-std::vector<uintptr_t> KittyScannerMgr::findBytesAll(const uintptr_t start, const uintptr_t end,
-                                                     const char *bytes, const std::string &mask) const
+std::vector<uintptr_t> KittyScannerMgr::findPatternAll(const uintptr_t start, const uintptr_t end, const KittyPattern &pattern) const
 {
-    std::vector<uintptr_t> local_list;
+    std::vector<uintptr_t> remote_list;
 
-    if (!_pMem || start >= end || !bytes || mask.empty())
-        return local_list;
+    if (!_pMem || start >= end || !pattern.isValid())
+        return remote_list;
+
+    const size_t scan_size = pattern.size();
+    uintptr_t next_search = start;
+
+    bool read = streamRange(start, end, scan_size - 1, [&](uintptr_t remote, const char *data, size_t size, size_t reportSize)
+    {
+        const uint8_t *local = (const uint8_t *)data;
+        const size_t local_size = std::min(size, reportSize + scan_size - 1);
+
+        size_t offset = next_search > remote ? next_search - remote : 0;
+        while (offset < reportSize)
+        {
+            size_t found = pattern.find(local, local_size, offset);
+            if (found == KittyPattern::npos)
+                break;
+
+            remote_list.push_back(remote + found);
+            offset = found + scan_size;
+            next_search = remote + offset;
+        }
+        return true;
+    });
+
+    if (!read)
+        KITTY_LOGE("findPatternAll: failed to read into buffer.");
+
+    return remote_list;
+}
+
+uintptr_t KittyScannerMgr::findPatternFirst(const uintptr_t start, const uintptr_t end, const KittyPattern &pattern) const
+{
+    if (!_pMem || start >= end || !pattern.isValid())
+        return 0;
+
+    const size_t scan_size = pattern.size();
+    uintptr_t result = 0;
+
+    bool read = streamRange(start, end, scan_size - 1, [&](uintptr_t remote, const char *data, size_t size, size_t reportSize)
+    {
+        size_t found = pattern.find((const uint8_t *)data, std::min(size, reportSize + scan_size - 1));
+        if (found != KittyPattern::npos)
+            result = remote + found;
+
+        return !result;
+    });
+
+    if (!read)
+        KITTY_LOGE("findPatternFirst: failed to read into buffer.");
+
+    return result;
+}
 
-    std::vector<char> buf(end - start);
-    if (!_pMem->Read(start, &buf[0], buf.size()))
+void KittyScannerMgr::scanMany(uintptr_t start, uintptr_t end, const std::vector<KittyPattern> &patterns, bool firstOnly,
+                               const std::function<bool(size_t id, uintptr_t address)> &onFound) const
+{
+    if (!_pMem || start >= end || patterns.empty())
+        return;
+
+    // candidate filter of a pattern, anchor is the pattern offset of its bucket key
+    struct AnchorEntry
+    {
+        uint32_t id;
+        uint32_t anchor, second;
+        uint32_t size;
+        uint8_t secondByte;
+    };
+
+    // patterns with two adjacent fully masked bytes are bucketed by that 16 bit pair,
+    // the rest by their rarest byte, a sparse pair table keeps candidates rare with hundreds of patterns
+    std::vector<std::pair<uint32_t, AnchorEntry>> pairKeys, byteKeys;
+    std::vector<size_t> noAnchor;
+    size_t maxSize = 0, remaining = 0;
+    for (size_t id = 0; id < patterns.size(); id++)
     {
-        KITTY_LOGE("findBytesAll: failed to read into buffer.");
-        return local_list;
+        const auto &pat = patterns[id];
+        if (!pat.isValid())
+            continue;
+
+        remaining++;
+        maxSize = std::max(maxSize, pat.size());
+
+        if (!pat.hasAnchor())
+        {
+            noAnchor.push_back(id);
+            continue;
+        }
+
+        const auto &bytes = pat.bytes();
+        const auto &mask = pat.mask();
+        const size_t anchor = pat.anchor();
+
+        // prefer a pair containing the rarest byte
+        size_t pair = KittyPattern::npos;
+        if (anchor + 1 < pat.size() && mask[anchor + 1] == 0xFF)
+            pair = anchor;
+        else if (anchor > 0 && mask[anchor - 1] == 0xFF)
+            pair = anchor - 1;
+        else
+        {
+            for (size_t i = 0; i + 1 < pat.size() && pair == KittyPattern::npos; i++)
+            {
+                if (mask[i] == 0xFF && mask[i + 1] == 0xFF)
+                    pair = i;
+            }
+        }
+
+        AnchorEntry entry = {};
+        entry.id = uint32_t(id);
+        entry.second = uint32_t(pat.secondAnchor());
+        entry.size = uint32_t(pat.size());
+        entry.secondByte = bytes[pat.secondAnchor()];
+
+        if (pair != KittyPattern::npos)
+        {
+            entry.anchor = uint32_t(pair);
+            pairKeys.emplace_back(bytes[pair] | (bytes[pair + 1] << 8), entry);
+        }
+        else
+        {
+            entry.anchor = uint32_t(anchor);
+            byteKeys.emplace_back(bytes[anchor], entry);
+        }
     }
 
-    uintptr_t curr_search_address = (uintptr_t)&buf[0];
-    const size_t scan_size = mask.length();
-    do
+    if (!remaining)
+        return;
+
+    // counting sort keys into flat bucket arrays
+    auto buildBuckets = [](const std::vector<std::pair<uint32_t, AnchorEntry>> &keys, size_t nBuckets,
+                           std::vector<uint32_t> &bucketStart, std::vector<AnchorEntry> &entries)
     {
-        if (!local_list.empty())
-            curr_search_address = local_list.back() + scan_size;
+        if (keys.empty())
+            return;
 
-        uintptr_t found = findInRange(curr_search_address, (uintptr_t(&buf[0]) + buf.size()), bytes, mask);
-        if (!found)
-            break;
+        bucketStart.assign(nBuckets + 1, 0);
+        for (auto &it : keys)
+            bucketStart[it.first + 1]++;
+
+        for (size_t i = 1; i < bucketStart.size(); i++)
+            bucketStart[i] += bucketStart[i - 1];
+
+        entries.resize(keys.size());
+        std::vector<uint32_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+        for (auto &it : keys)
+            entries[fill[it.first]++] = it.second;
+    };
+
+    std::vector<uint32_t> pairStart, byteStart;
+    std::vector<AnchorEntry> pairEntries, byteEntries;
+    buildBuckets(pairKeys, 0x10000, pairStart, pairEntries);
+    buildBuckets(byteKeys, 0x100, byteStart, byteEntries);
+
+    // per pattern next allowed match address, matches of the same pattern don't overlap
+    std::vector<uintptr_t> nextSearch(patterns.size(), start);
+    std::vector<uint8_t> done(patterns.size(), 0);
 
-        local_list.push_back(found);
-    } while (true);
+    bool read = streamRange(start, end, maxSize - 1, [&](uintptr_t remote, const char *data, size_t size, size_t reportSize)
+    {
+        const uint8_t *local = (const uint8_t *)data;
+
+        auto report = [&](size_t id, size_t offset) -> bool
+        {
+            const size_t patSize = patterns[id].size();
+            nextSearch[id] = remote + offset + patSize;
+            if (firstOnly)
+            {
+                done[id] = 1;
+                remaining--;
+            }
+            return onFound(id, remote + offset) && remaining;
+        };
+
+        for (size_t id : noAnchor)
+        {
+            if (done[id])
+                continue;
+
+            const size_t patSize = patterns[id].size();
+            size_t offset = nextSearch[id] > remote ? nextSearch[id] - remote : 0;
+            while (offset < reportSize && offset + patSize <= size)
+            {
+                if (!report(id, offset))
+                    return false;
+
+                if (firstOnly)
+                    break;
+
+                offset += patSize;
+            }
+        }
+
+        // returns false to stop scanning
+        auto visit = [&](const AnchorEntry &entry, size_t j) -> bool
+        {
+            if (j < entry.anchor)
+                return true;
 
-    if (local_list.empty())
-        return local_list;
+            const size_t offset = j - entry.anchor;
+            if (offset >= reportSize || offset + entry.size > size || local[offset + entry.second] != entry.secondByte)
+                return true;
 
+            if (done[entry.id] || remote + offset < nextSearch[entry.id] || !patterns[entry.id].matches(local + offset))
+                return true;
+
+            return report(entry.id, offset);
+        };
+
+        for (size_t j = 0; j < size; j++)
+        {
+            if (!pairEntries.empty() && j + 1 < size)
+            {
+                const uint32_t key = local[j] | (local[j + 1] << 8);
+                for (uint32_t k = pairStart[key]; k < pairStart[key + 1]; k++)
+                {
+                    if (!visit(pairEntries[k], j))
+                        return false;
+                }
+            }
+
+            if (!byteEntries.empty())
+            {
+                const uint32_t key = local[j];
+                for (uint32_t k = byteStart[key]; k < byteStart[key + 1]; k++)
+                {
+                    if (!visit(byteEntries[k], j))
+                        return false;
+                }
+            }
+        }
+        return true;
+    });
+
+    if (!read)
+        KITTY_LOGE("scanMany: failed to read into buffer.");
+}
+
+std::vector<std::vector<uintptr_t>> KittyScannerMgr::findManyAll(const uintptr_t start, const uintptr_t end, const std::vector<KittyPattern> &patterns) const
+{
+    std::vector<std::vector<uintptr_t>> results(patterns.size());
+
+    scanMany(start, end, patterns, false, [&](size_t id, uintptr_t address)
+    {
+        results[id].push_back(address);
+        return true;
+    });
+
+    return results;
+}
+
+std::vector<uintptr_t> KittyScannerMgr::findManyFirst(const uintptr_t start, const uintptr_t end, const std::vector<KittyPattern> &patterns) const
+{
+    std::vector<uintptr_t> results(patterns.size(), 0);
+
+    scanMany(start, end, patterns, true, [&](size_t id, uintptr_t address)
+    {
+        results[id] = address;
+        return true;
+    });
+
+    return results;
+}
+
+std::shared_ptr<KittyThreadPool> KittyScannerMgr::threadPool() const
+{
+    return _threadPool ? _threadPool : KittyThreadPool::shared();
+}
+
+std::vector<KittyScannerMgr::ScanItem> KittyScannerMgr::splitMaps(const std::vector<KittyMemoryEx::ProcMap> &maps) const
+{
+    // a few scan windows per item, small enough to balance between workers
+    const size_t itemSize = _chunkSize * 4;
+
+    std::vector<ScanItem> items;
+    for (size_t i = 0; i < maps.size(); i++)
+    {
+        const uintptr_t mapStart = maps[i].startAddress, mapEnd = maps[i].endAddress;
+        for (uintptr_t start = mapStart; start < mapEnd; start += itemSize)
+            items.push_back({i, start, std::min<uintptr_t>(mapEnd, start + itemSize), mapEnd});
+    }
+    return items;
+}
+
+std::vector<uintptr_t> KittyScannerMgr::findPatternAllInMaps(const KittyMapFilter &filter, const KittyPattern &pattern) const
+{
     std::vector<uintptr_t> remote_list;
-    for (auto &it : local_list)
+
+    if (!_pMem || !pattern.isValid())
+        return remote_list;
+
+    // all maps are kept for ReadPages so faulting windows don't reparse the maps file
+    const auto allMaps = KittyMemoryEx::getAllMaps(_pMem->remotePID());
+    std::vector<KittyMemoryEx::ProcMap> maps;
+    for (auto &it : allMaps)
+    {
+        if (filter.matches(it))
+            maps.push_back(it);
+    }
+
+    const auto items = splitMaps(maps);
+    const size_t scan_size = pattern.size();
+
+    // items collect overlapping matches, non overlapping ones are picked when merging
+    // so results are the same as scanning each map in one go
+    std::vector<std::vector<uintptr_t>> itemResults(items.size());
+    threadPool()->run(items.size(), [&](size_t i)
+    {
+        const ScanItem &item = items[i];
+        auto &results = itemResults[i];
+
+        const uintptr_t scanEnd = std::min<uintptr_t>(item.mapEnd, item.end + scan_size - 1);
+        streamRange(item.start, scanEnd, scan_size - 1, [&](uintptr_t remote, const char *data, size_t size, size_t reportSize)
+        {
+            const uint8_t *local = (const uint8_t *)data;
+            const size_t local_size = std::min(size, reportSize + scan_size - 1);
+
+            size_t offset = 0;
+            while (offset < reportSize)
+            {
+                size_t found = pattern.find(local, local_size, offset);
+                if (found == KittyPattern::npos)
+                    break;
+
+                if (remote + found >= item.end)
+                    return false;
+
+                results.push_back(remote + found);
+                offset = found + 1;
+            }
+            return true;
+        }, &allMaps);
+    });
+
+    size_t currMap = size_t(-1);
+    uintptr_t next_search = 0;
+    for (size_t i = 0; i < items.size(); i++)
     {
-        remote_list.push_back((it - (uintptr_t(&buf[0]))) + start);
+        if (items[i].map != currMap)
+        {
+            currMap = items[i].map;
+            next_search = 0;
+        }
+
+        for (uintptr_t found : itemResults[i])
+        {
+            if (found < next_search)
+                continue;
+
+            remote_list.push_back(found);
+            next_search = found + scan_size;
+        }
     }
 
     return remote_list;
 }
 
-uintptr_t KittyScannerMgr::findBytesFirst(const uintptr_t start, const uintptr_t end, const char *bytes, const std::string &mask) const
+uintptr_t KittyScannerMgr::findPatternFirstInMaps(const KittyMapFilter &filter, const KittyPattern &pattern) const
 {
-    if (!_pMem || start >= end || !bytes || mask.empty())
+    if (!_pMem || !pattern.isValid())
         return 0;
 
-    std::vector<char> buf(end - start);
-    if (_pMem->Read(start, &buf[0], buf.size()) != buf.size())
+    // all maps are kept for ReadPages so faulting windows don't reparse the maps file
+    const auto allMaps = KittyMemoryEx::getAllMaps(_pMem->remotePID());
+    std::vector<KittyMemoryEx::ProcMap> maps;
+    for (auto &it : allMaps)
     {
-        KITTY_LOGE("findBytesFirst: failed to read into buffer.");
-        return 0;
+        if (filter.matches(it))
+            maps.push_back(it);
     }
 
-    uintptr_t local = findInRange((uintptr_t)&buf[0], (uintptr_t(&buf[0]) + buf.size()), bytes, mask);
-    if (local)
-        return (local - (uintptr_t(&buf[0]))) + start;
+    const auto items = splitMaps(maps);
+    const size_t scan_size = pattern.size();
 
-    return 0;
+    // lowest found address so far, items above it are skipped
+    std::atomic<uintptr_t> best(UINTPTR_MAX);
+    threadPool()->run(items.size(), [&](size_t i)
+    {
+        const ScanItem &item = items[i];
+        if (item.start >= best)
+            return;
+
+        const uintptr_t scanEnd = std::min<uintptr_t>(item.mapEnd, item.end + scan_size - 1);
+        streamRange(item.start, scanEnd, scan_size - 1, [&](uintptr_t remote, const char *data, size_t size, size_t reportSize)
+        {
+            if (remote >= best)
+                return false;
+
+            size_t found = pattern.find((const uint8_t *)data, std::min(size, reportSize + scan_size - 1));
+            if (found == KittyPattern::npos)
+                return true;
+
+            uintptr_t address = remote + found;
+            if (address < item.end)
+            {
+                uintptr_t curr = best;
+                while (address < curr && !best.compare_exchange_weak(curr, address))
+                    ;
+            }
+            return false;
+        }, &allMaps);
+    });
+
+    return best == UINTPTR_MAX ? 0 : uintptr_t(best);
 }
 
-std::vector<uintptr_t> KittyScannerMgr::findHexAll(const uintptr_t start, const uintptr_t end, std::string hex, const std::string &mask) const
+std::vector<uintptr_t> KittyScannerMgr::findBytesAll(const uintptr_t start, const uintptr_t end,
+                                                     const char *bytes, const std::string &mask) const
 {
-    std::vector<uintptr_t> list;
+    if (!_pMem || start >= end || !bytes || mask.empty())
+        return {};
 
-    if (!_pMem || start >= end || mask.empty() || !KittyUtils::validateHexString(hex))
-        return list;
+    return findPatternAll(start, end, KittyPattern(bytes, mask));
+}
+
+uintptr_t KittyScannerMgr::findBytesFirst(const uintptr_t start, const uintptr_t end, const char *bytes, const std::string &mask) const
+{
+    if (!_pMem || start >= end || !bytes || mask.empty())
+        return 0;
 
-    const size_t scan_size = mask.length();
-    if ((hex.length() / 2) != scan_size)
-        return list;
+    return findPatternFirst(start, end, KittyPattern(bytes, mask));
+}
 
-    std::vector<char> pattern(scan_size);
-    KittyUtils::dataFromHex(hex, &pattern[0]);
+std::vector<uintptr_t> KittyScannerMgr::findHexAll(const uintptr_t start, const uintptr_t end, std::string hex, const std::string &mask) const
+{
+    if (!_pMem || start >= end || mask.empty())
+        return {};
 
-    list = findBytesAll(start, end, pattern.data(), mask);
-    return list;
+    return findPatternAll(start, end, KittyPattern::fromHex(hex, mask));
 }
 
 uintptr_t KittyScannerMgr::findHexFirst(const uintptr_t start, const uintptr_t end, std::string hex, const std::string &mask) const
 {
-    if (!_pMem || start >= end || mask.empty() || !KittyUtils::validateHexString(hex))
-        return 0;
-
-    const size_t scan_size = mask.length();
-    if ((hex.length() / 2) != scan_size)
+    if (!_pMem || start >= end || mask.empty())
         return 0;
 
-    std::vector<char> pattern(scan_size);
-    KittyUtils::dataFromHex(hex, &pattern[0]);
-
-    return findBytesFirst(start, end, pattern.data(), mask);
+    return findPatternFirst(start, end, KittyPattern::fromHex(hex, mask));
 }
 
 std::vector<uintptr_t> KittyScannerMgr::findDataAll(const uintptr_t start, const uintptr_t end, const void *data, size_t size) const
 {
-    std::vector<uintptr_t> list;
-
     if (!_pMem || start >= end || !data || size < 1)
-        return list;
-
-    std::string mask(size, 'x');
+        return {};
 
-    list = findBytesAll(start, end, (const char *)data, mask);
-    return list;
+    return findPatternAll(start, end, KittyPattern::fromData(data, size));
 }
 
 uintptr_t KittyScannerMgr::findDataFirst(const uintptr_t start, const uintptr_t end, const void *data, size_t size) const
@@ -149,65 +583,89 @@ uintptr_t KittyScannerMgr::findDataFirst(const uintptr_t start, const uintptr_t
     if (!_pMem || start >= end || !data || size < 1)
         return 0;
 
-    std::string mask(size, 'x');
-
-    return findBytesFirst(start, end, (const char *)data, mask);
+    return findPatternFirst(start, end, KittyPattern::fromData(data, size));
 }
 
 /* ======================= ElfScanner ======================= */
 
 // refs https://gist.github.com/resilar/24bb92087aaec5649c9a2afc0b4350c8
 
-ElfScanner::ElfScanner(IKittyMemOp *pMem, uintptr_t elfBase)
+// NT_GNU_BUILD_ID desc as hex from a notes segment, empty if missing
+static std::string findBuildIdNote(const char *notes, size_t size)
 {
-    _pMem = nullptr;
-    _elfBase = 0;
-    _ehdr = {};
-    _loads = 0;
-    _loadBias = 0;
-    _loadSize = 0;
-    _stringTable = 0;
-    _symbolTable = 0;
-    _strsz = 0;
-    _syment = 0;
+    // name & desc are padded to 4 bytes
+    for (size_t offset = 0; offset + sizeof(ElfW_(Nhdr)) <= size;)
+    {
+        ElfW_(Nhdr) nhdr{};
+        memcpy(&nhdr, notes + offset, sizeof(nhdr));
+        if (nhdr.n_namesz > size || nhdr.n_descsz > size)
+            break;
+
+        const size_t nameOffset = offset + sizeof(nhdr);
+        const size_t descOffset = nameOffset + ((nhdr.n_namesz + 3) & ~size_t(3));
+        offset = descOffset + ((nhdr.n_descsz + 3) & ~size_t(3));
+        if (descOffset + nhdr.n_descsz > size)
+            break;
+
+        if (nhdr.n_type == NT_GNU_BUILD_ID && nhdr.n_descsz && nhdr.n_namesz == 4 && memcmp(notes + nameOffset, "GNU", 4) == 0)
+            return KittyUtils::data2Hex(notes + descOffset, nhdr.n_descsz);
+    }
+    return "";
+}
 
+const ElfScanner::ElfData &ElfScanner::emptyData()
+{
+    static const ElfData empty;
+    return empty;
+}
+
+ElfScanner::ElfScanner(IKittyMemOp *pMem, uintptr_t elfBase, bool lazySymbols, const std::string &symbolCacheDir,
+                       const std::string &filePath)
+{
     if (!pMem || !elfBase)
         return;
 
-    _pMem = pMem;
-    _elfBase = elfBase;
+    // filled in place, headers of an invalid ELF stay readable through accessors
+    auto data = std::make_shared<ElfData>();
+    _data = data;
+
+    ElfData &d = *data;
+    d.pMem = pMem;
+    d.elfBase = elfBase;
+    d.symbolCacheDir = symbolCacheDir;
+    d.filePath = filePath;
 
     // read ELF header
-    if (!_pMem->Read(elfBase, &_ehdr, sizeof(_ehdr)))
+    if (!d.pMem->Read(elfBase, &d.ehdr, sizeof(d.ehdr)))
     {
         KITTY_LOGD("ElfScanner: failed to read ELF (%p) header.", (void *)elfBase);
         return;
     }
 
     // verify ELF header
-    if (memcmp(_ehdr.e_ident, "\177ELF", 4) != 0)
+    if (memcmp(d.ehdr.e_ident, "\177ELF", 4) != 0)
     {
         KITTY_LOGD("ElfScanner: (%p) is not a valid ELF.", (void *)elfBase);
         return;
     }
 
     // check ELF bit
-    if (_ehdr.e_ident[EI_CLASS] != ELF_EICLASS_)
+    if (d.ehdr.e_ident[EI_CLASS] != ELF_EICLASS_)
     {
         KITTY_LOGD("ElfScanner: ELF class mismatch (%p).", (void *)elfBase);
         return;
     }
 
     // check common header values
-    if (!_ehdr.e_phnum || !_ehdr.e_phentsize || !_ehdr.e_shnum || !_ehdr.e_shentsize)
+    if (!d.ehdr.e_phnum || !d.ehdr.e_phentsize || !d.ehdr.e_shnum || !d.ehdr.e_shentsize)
     {
         KITTY_LOGD("ElfScanner: Invalid header values (%p).", (void *)elfBase);
         return;
     }
 
     // read all program headers
-    std::vector<char> phdrs_buf(_ehdr.e_phnum * _ehdr.e_phentsize);
-    if (!_pMem->Read(elfBase + _ehdr.e_phoff, &phdrs_buf[0], phdrs_buf.size()))
+    std::vector<char> phdrs_buf(d.ehdr.e_phnum * d.ehdr.e_phentsize);
+    if (!d.pMem->Read(elfBase + d.ehdr.e_phoff, &phdrs_buf[0], phdrs_buf.size()))
     {
         KITTY_LOGD("ElfScanner: failed to read ELF (%p) program headers.", (void *)elfBase);
         return;
@@ -215,15 +673,15 @@ ElfScanner::ElfScanner(IKittyMemOp *pMem, uintptr_t elfBase)
 
     // find load bias
     uintptr_t min_vaddr = UINTPTR_MAX, max_vaddr = 0;
-    for (ElfW_(Half) i = 0; i < _ehdr.e_phnum; i++)
+    for (ElfW_(Half) i = 0; i < d.ehdr.e_phnum; i++)
     {
         ElfW_(Phdr) phdr_entry = {};
-        memcpy(&phdr_entry, phdrs_buf.data() + (i * _ehdr.e_phentsize), _ehdr.e_phentsize);
-        _phdrs.push_back(phdr_entry);
+        memcpy(&phdr_entry, phdrs_buf.data() + (i * d.ehdr.e_phentsize), d.ehdr.e_phentsize);
+        d.phdrs.push_back(phdr_entry);
 
         if (phdr_entry.p_type == PT_LOAD)
         {
-            _loads++;
+            d.loads++;
             if (phdr_entry.p_vaddr < min_vaddr)
                 min_vaddr = phdr_entry.p_vaddr;
 
@@ -232,7 +690,7 @@ ElfScanner::ElfScanner(IKittyMemOp *pMem, uintptr_t elfBase)
         }
     }
 
-    if (!_loads)
+    if (!d.loads)
     {
         KITTY_LOGD("ElfScanner: No loads entry for ELF (%p).", (void *)elfBase);
         return;
@@ -247,17 +705,31 @@ ElfScanner::ElfScanner(IKittyMemOp *pMem, uintptr_t elfBase)
     min_vaddr = KT_PAGE_START(min_vaddr);
     max_vaddr = KT_PAGE_END(max_vaddr);
 
-    _loadBias = elfBase - min_vaddr;
-    _loadSize = max_vaddr - min_vaddr;
+    d.loadBias = elfBase - min_vaddr;
+    d.loadSize = max_vaddr - min_vaddr;
+
+    // GNU build-id, identifies ELF content for the symbol cache
+    for (auto &phdr : d.phdrs)
+    {
+        if (phdr.p_type != PT_NOTE || phdr.p_memsz < sizeof(ElfW_(Nhdr)))
+            continue;
+
+        std::vector<char> notes(std::min(size_t(phdr.p_memsz), size_t(KT_ELF_NOTES_MAX_SIZE)));
+        notes.resize(d.pMem->Read(d.loadBias + phdr.p_vaddr, notes.data(), notes.size()));
+
+        d.buildId = findBuildIdNote(notes.data(), notes.size());
+        if (!d.buildId.empty())
+            break;
+    }
 
     // read all dynamics
-    for (auto &phdr : _phdrs)
+    for (auto &phdr : d.phdrs)
     {
         if (phdr.p_type == PT_DYNAMIC)
         {
-            uintptr_t dyn_addr = _loadBias + phdr.p_vaddr;
+            uintptr_t dyn_addr = d.loadBias + phdr.p_vaddr;
             std::vector<ElfW_(Dyn)> dyn_buff(phdr.p_memsz / sizeof(ElfW_(Dyn)));
-            if (!_pMem->Read(dyn_addr, &dyn_buff[0], phdr.p_memsz))
+            if (!d.pMem->Read(dyn_addr, &dyn_buff[0], phdr.p_memsz))
             {
                 KITTY_LOGD("ElfScanner: failed to read dynamic for ELF (%p).", (void *)elfBase);
                 break;
@@ -273,76 +745,798 @@ ElfScanner::ElfScanner(IKittyMemOp *pMem, uintptr_t elfBase)
                 {
                     // mandatory
                 case DT_STRTAB: // string table
-                    _stringTable = dyn.d_un.d_ptr;
+                    d.stringTable = dyn.d_un.d_ptr;
                     break;
                     // mandatory
                 case DT_SYMTAB: // symbol table
-                    _symbolTable = dyn.d_un.d_ptr;
+                    d.symbolTable = dyn.d_un.d_ptr;
                     break;
                     // mandatory
                 case DT_STRSZ: // string table size
-                    _strsz = dyn.d_un.d_val;
+                    d.strsz = dyn.d_un.d_val;
                     break;
                     // mandatory
                 case DT_SYMENT: // symbol entry size
-                    _syment = dyn.d_un.d_val;
+                    d.syment = dyn.d_un.d_val;
+                    break;
+                case DT_GNU_HASH:
+                    d.gnuHash = dyn.d_un.d_ptr;
+                    break;
+                case DT_HASH:
+                    d.sysvHash = dyn.d_un.d_ptr;
+                    break;
+                case DT_JMPREL:
+                    d.jmprel = dyn.d_un.d_ptr;
+                    break;
+                case DT_PLTRELSZ:
+                    d.pltrelsz = dyn.d_un.d_val;
+                    break;
+                case DT_PLTREL:
+                    d.pltrel = int(dyn.d_un.d_val);
+                    break;
+                case DT_RELA:
+                    d.rela = dyn.d_un.d_ptr;
+                    break;
+                case DT_RELASZ:
+                    d.relasz = dyn.d_un.d_val;
+                    break;
+                case DT_RELAENT:
+                    d.relaent = dyn.d_un.d_val;
+                    break;
+                case DT_REL:
+                    d.rel = dyn.d_un.d_ptr;
+                    break;
+                case DT_RELSZ:
+                    d.relsz = dyn.d_un.d_val;
+                    break;
+                case DT_RELENT:
+                    d.relent = dyn.d_un.d_val;
                     break;
                 default:
                     break;
                 }
 
-                _dynamics.push_back(dyn);
+                d.dynamics.push_back(dyn);
             }
         }
     }
 
     // check required dynamics for symbol lookup
-    if (!_stringTable || !_symbolTable || !_strsz || !_syment)
+    if (!d.stringTable || !d.symbolTable || !d.strsz || !d.syment)
     {
         KITTY_LOGD("ElfScanner: failed to require dynamics for symbol lookup.");
         KITTY_LOGD("ElfScanner: elfBase: %p | strtab=%p | symtab=%p | strsz=%p | syment=%p",
-                   (void *)elfBase, (void *)_stringTable, (void *)_symbolTable, (void *)_strsz, (void *)_syment);
+                   (void *)elfBase, (void *)d.stringTable, (void *)d.symbolTable, (void *)d.strsz, (void *)d.syment);
         return;
     }
 
     auto fix_table_address = [&](uintptr_t &table_addr)
     {
-        if (table_addr && table_addr < _loadBias)
-            table_addr += _loadBias;
+        if (table_addr && table_addr < d.loadBias)
+            table_addr += d.loadBias;
     };
-    auto get_sym_address = [&](const ElfW_(Sym) & sym_ent) -> uintptr_t
+
+    fix_table_address(d.stringTable);
+    fix_table_address(d.symbolTable);
+    fix_table_address(d.gnuHash);
+    fix_table_address(d.sysvHash);
+    fix_table_address(d.jmprel);
+    fix_table_address(d.rela);
+    fix_table_address(d.rel);
+
+    // nbuckets, symoffset, bloom_size, bloom_shift
+    uint32_t gnuHeader[4] = {};
+    if (d.gnuHash && d.pMem->Read(d.gnuHash, gnuHeader, sizeof(gnuHeader)) == sizeof(gnuHeader) && gnuHeader[0] && gnuHeader[2])
     {
-        return sym_ent.st_value < _loadBias ? _loadBias + sym_ent.st_value : sym_ent.st_value;
-    };
+        d.gnuNBuckets = gnuHeader[0];
+        d.gnuSymOffset = gnuHeader[1];
+        d.gnuBloomSize = gnuHeader[2];
+        d.gnuBloomShift = gnuHeader[3];
+    }
+    else
+    {
+        d.gnuHash = 0;
+    }
 
-    fix_table_address(_stringTable);
-    fix_table_address(_symbolTable);
+    // nbucket, nchain
+    uint32_t sysvHeader[2] = {};
+    if (d.sysvHash && d.pMem->Read(d.sysvHash, sysvHeader, sizeof(sysvHeader)) == sizeof(sysvHeader) && sysvHeader[0])
+    {
+        d.sysvNBuckets = sysvHeader[0];
+        d.sysvNChains = sysvHeader[1];
+    }
+    else
+    {
+        d.sysvHash = 0;
+    }
 
-    // linear search
-    uintptr_t sym_entry = _symbolTable;
-    for (; sym_entry; sym_entry += _syment)
+    if (!lazySymbols)
+        symbolsData();
+}
+
+const ElfScanner::SymbolsData *ElfScanner::symbolsData() const
+{
+    if (!isValid())
+        return nullptr;
+
+    SymbolsData &symbols = _data->symbols;
+    std::call_once(symbols.once, [&]
+                   {
+                       readSymbols(symbols);
+                       symbols.ready.store(true, std::memory_order_release);
+                   });
+    return &symbols;
+}
+
+const std::vector<std::pair<uintptr_t, std::string_view>> &ElfScanner::symbols() const
+{
+    auto symbols = symbolsData();
+    return symbols ? symbols->symbols : emptyData().symbols.symbols;
+}
+
+size_t ElfScanner::dynamicSymbolCount() const
+{
+    const ElfData &d = *_data;
+
+    if (d.sysvHash)
+        return d.sysvNChains;
+
+    if (!d.gnuHash)
+        return 0;
+
+    // sizes come from target memory, a table can't be larger than the ELF
+    if (uintptr_t(d.gnuNBuckets) * sizeof(uint32_t) > d.loadSize)
+        return 0;
+
+    // highest bucket start, then follow its chain to the end
+    std::vector<uint32_t> buckets(d.gnuNBuckets);
+    const uintptr_t bucketsAddr = d.gnuHash + 16 + (uintptr_t(d.gnuBloomSize) * sizeof(ElfW_(Addr)));
+    const uintptr_t chainsAddr = bucketsAddr + (uintptr_t(d.gnuNBuckets) * sizeof(uint32_t));
+    if (d.pMem->Read(bucketsAddr, buckets.data(), buckets.size() * sizeof(uint32_t)) != buckets.size() * sizeof(uint32_t))
+        return 0;
+
+    uint32_t last = 0;
+    for (uint32_t it : buckets)
+        last = std::max(last, it);
+
+    if (last < d.gnuSymOffset)
+        return d.gnuSymOffset;
+
+    uint32_t chain[16];
+    for (uint32_t index = last;;)
+    {
+        if (uintptr_t(index - d.gnuSymOffset) * sizeof(uint32_t) > d.loadSize)
+            return 0;
+
+        size_t count = d.pMem->Read(chainsAddr + (uintptr_t(index - d.gnuSymOffset) * sizeof(uint32_t)), chain, sizeof(chain)) / sizeof(uint32_t);
+        if (!count)
+            return 0;
+
+        for (size_t i = 0; i < count; i++, index++)
+        {
+            if (chain[i] & 1)
+                return index + 1;
+        }
+    }
+}
+
+bool ElfScanner::readDynamicSymbols(SymbolsData &symbols) const
+{
+    const ElfData &d = *_data;
+
+    size_t symCount = dynamicSymbolCount();
+
+    // no hash table, dynsym is usually right before dynstr
+    if (!symCount && d.stringTable > d.symbolTable)
+        symCount = (d.stringTable - d.symbolTable) / d.syment;
+
+    if (!symCount)
+    {
+        KITTY_LOGD("ElfScanner: failed to find symbols count of ELF (%p).", (void *)d.elfBase);
+        return false;
+    }
+
+    // sizes come from target memory, tables can't be larger than the ELF
+    if (symCount > d.loadSize / d.syment || d.strsz > d.loadSize)
+    {
+        KITTY_LOGD("ElfScanner: invalid symbols size of ELF (%p).", (void *)d.elfBase);
+        return false;
+    }
+
+    std::vector<char> symtab(symCount * d.syment);
+    const size_t symtabSize = d.pMem->Read(d.symbolTable, symtab.data(), symtab.size());
+    const bool complete = symtabSize == symtab.size();
+    symCount = symtabSize / d.syment;
+
+    // extra null so the last name is always terminated
+    std::vector<char> &strtab = symbols.strtab;
+    strtab.assign(d.strsz + 1, 0);
+    const size_t strsz = d.pMem->Read(d.stringTable, strtab.data(), d.strsz);
+    if (!symCount || !strsz)
+    {
+        KITTY_LOGD("ElfScanner: failed to read symbols of ELF (%p).", (void *)d.elfBase);
+        return false;
+    }
+
+    symbols.symbols.reserve(symCount);
+    for (size_t i = 0; i < symCount; i++)
     {
         ElfW_(Sym) curr_sym{};
-        if (!_pMem->Read(sym_entry, &curr_sym, _syment) || curr_sym.st_name >= _strsz)
-            break;
+        memcpy(&curr_sym, symtab.data() + (i * d.syment), std::min(d.syment, sizeof(curr_sym)));
 
-        if (!curr_sym.st_name || !curr_sym.st_value)
+        if (!curr_sym.st_name || !curr_sym.st_value || curr_sym.st_name >= strsz)
             continue;
 
-        std::string sym_str = _pMem->ReadStr(_stringTable + curr_sym.st_name, 1024);
-        if (!sym_str.empty())
-            _symbols.emplace_back(get_sym_address(curr_sym), sym_str);
+        const char *name = strtab.data() + curr_sym.st_name;
+        const size_t len = strnlen(name, strsz - curr_sym.st_name);
+        if (!len)
+            continue;
+
+        symbols.symbols.emplace_back(symbolAddress(curr_sym), std::string_view(name, len));
     }
+
+    return complete && strsz == d.strsz;
 }
 
-uintptr_t ElfScanner::findSymbol(const std::string &symbolName) const
+void ElfScanner::readFileSymbols(SymbolsData &symbols) const
+{
+    const ElfData &d = *_data;
+
+    int fd = open(d.filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        KITTY_LOGD("ElfScanner: failed to open ELF file %s.", d.filePath.c_str());
+        return;
+    }
+
+    struct stat st{};
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(ElfW_(Ehdr)))
+        map = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (map == MAP_FAILED)
+    {
+        KITTY_LOGD("ElfScanner: failed to map ELF file %s.", d.filePath.c_str());
+        return;
+    }
+
+    const size_t size = size_t(st.st_size);
+    std::shared_ptr<void> fileMap(map, [size](void *p)
+                                  { munmap(p, size); });
+
+    const char *file = (const char *)map;
+    ElfW_(Ehdr) ehdr{};
+    memcpy(&ehdr, file, sizeof(ehdr));
+    if (memcmp(ehdr.e_ident, "\177ELF", 4) != 0 || ehdr.e_ident[EI_CLASS] != ELF_EICLASS_ ||
+        ehdr.e_shentsize < sizeof(ElfW_(Shdr)) || !ehdr.e_shnum || ehdr.e_shoff >= size ||
+        (size - ehdr.e_shoff) / ehdr.e_shentsize < ehdr.e_shnum)
+    {
+        KITTY_LOGD("ElfScanner: invalid ELF file %s.", d.filePath.c_str());
+        return;
+    }
+
+    // make sure the file is the one loaded, a file whose program headers can't be checked is rejected
+    if (!d.buildId.empty())
+    {
+        if (ehdr.e_phentsize < sizeof(ElfW_(Phdr)) || !ehdr.e_phnum || ehdr.e_phoff >= size ||
+            (size - ehdr.e_phoff) / ehdr.e_phentsize < ehdr.e_phnum)
+        {
+            KITTY_LOGD("ElfScanner: ELF file %s has invalid program headers.", d.filePath.c_str());
+            return;
+        }
+
+        std::string fileBuildId;
+        for (ElfW_(Half) i = 0; i < ehdr.e_phnum && fileBuildId.empty(); i++)
+        {
+            ElfW_(Phdr) phdr{};
+            memcpy(&phdr, file + ehdr.e_phoff + (i * ehdr.e_phentsize), sizeof(phdr));
+            if (phdr.p_type == PT_NOTE && phdr.p_offset < size && phdr.p_filesz <= size - phdr.p_offset)
+                fileBuildId = findBuildIdNote(file + phdr.p_offset, phdr.p_filesz);
+        }
+
+        if (fileBuildId != d.buildId)
+        {
+            KITTY_LOGD("ElfScanner: ELF file %s build-id mismatch.", d.filePath.c_str());
+            return;
+        }
+    }
+
+    auto sectionHeader = [&](size_t index)
+    {
+        ElfW_(Shdr) shdr{};
+        memcpy(&shdr, file + ehdr.e_shoff + (index * ehdr.e_shentsize), sizeof(shdr));
+        return shdr;
+    };
+
+    size_t added = 0;
+    for (ElfW_(Half) i = 0; i < ehdr.e_shnum; i++)
+    {
+        const ElfW_(Shdr) symtab = sectionHeader(i);
+        if (symtab.sh_type != SHT_SYMTAB || symtab.sh_link >= ehdr.e_shnum || symtab.sh_entsize < sizeof(ElfW_(Sym)) ||
+            symtab.sh_offset >= size || symtab.sh_size > size - symtab.sh_offset)
+            continue;
+
+        const ElfW_(Shdr) strtab = sectionHeader(symtab.sh_link);
+        if (strtab.sh_type != SHT_STRTAB || strtab.sh_offset >= size || strtab.sh_size > size - strtab.sh_offset)
+            continue;
+
+        const char *strs = file + strtab.sh_offset;
+        const size_t symCount = symtab.sh_size / symtab.sh_entsize;
+        symbols.symbols.reserve(symbols.symbols.size() + symCount);
+
+        for (size_t j = 0; j < symCount; j++)
+        {
+            ElfW_(Sym) sym{};
+            memcpy(&sym, file + symtab.sh_offset + (j * symtab.sh_entsize), sizeof(sym));
+
+            const int type = ELFW_(ST_TYPE)(sym.st_info);
+            if (!sym.st_name || !sym.st_value || sym.st_shndx == SHN_UNDEF || sym.st_name >= strtab.sh_size ||
+                type == STT_SECTION || type == STT_FILE || type == STT_TLS)
+                continue;
+
+            const char *name = strs + sym.st_name;
+            const size_t len = strnlen(name, strtab.sh_size - sym.st_name);
+            if (!len)
+                continue;
+
+            const std::string_view symName(name, len);
+            const uintptr_t symAddress = symbolAddress(sym);
+
+            // symtab repeats dynsym entries
+            auto it = symbols.index.find(symName);
+            if (it != symbols.index.end() && it->second == symAddress)
+                continue;
+
+            symbols.symbols.emplace_back(symAddress, symName);
+            symbols.index.emplace(symName, symAddress);
+            added++;
+        }
+    }
+
+    if (added)
+        symbols.fileMap = std::move(fileMap);
+
+    KITTY_LOGD("ElfScanner: added %zu symbols from ELF file %s.", added, d.filePath.c_str());
+}
+
+void ElfScanner::readSymbols(SymbolsData &symbols) const
+{
+    const std::string cachePath = symbolCachePath();
+    if (cachePath.empty() || !loadSymbolCache(cachePath, symbols))
+    {
+        // a short read would be cached for good, only complete tables are stored
+        const bool complete = readDynamicSymbols(symbols);
+
+        if (!cachePath.empty() && complete && !symbols.symbols.empty() && !storeSymbolCache(cachePath, symbols))
+            KITTY_LOGD("ElfScanner: failed to store symbol cache %s.", cachePath.c_str());
+    }
+
+    symbols.index.reserve(symbols.symbols.size());
+    // first one wins like a linear search would
+    for (auto &it : symbols.symbols)
+        symbols.index.emplace(it.second, it.first);
+
+    // cache only holds dynamic symbols, file symbols are cheap to map again
+    if (!_data->filePath.empty())
+        readFileSymbols(symbols);
+}
+
+std::string ElfScanner::symbolCachePath() const
+{
+    const ElfData &d = *_data;
+    if (d.symbolCacheDir.empty() || d.buildId.empty())
+        return "";
+
+    return d.symbolCacheDir + "/" + d.buildId + ".ksym";
+}
+
+/**
+ * Symbol cache file, addresses are relative to load bias:
+ * header | entries[count] | null terminated names[namesSize]
+ */
+#define KT_SYMBOL_CACHE_MAGIC "KTSYMC1"
+
+struct SymbolCacheHeader
+{
+    char magic[8];
+    uint32_t count;
+    uint32_t namesSize;
+};
+
+struct SymbolCacheEntry
+{
+    uint64_t offset;
+    uint32_t name;
+    uint32_t nameLength;
+};
+
+bool ElfScanner::loadSymbolCache(const std::string &path, SymbolsData &symbols) const
+{
+    const ElfData &d = *_data;
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    struct stat st{};
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(SymbolCacheHeader))
+        map = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (map == MAP_FAILED)
+        return false;
+
+    const size_t size = size_t(st.st_size);
+    symbols.cacheMap = std::shared_ptr<void>(map, [size](void *p)
+                                             { munmap(p, size); });
+
+    const char *base = (const char *)map;
+    SymbolCacheHeader header{};
+    memcpy(&header, base, sizeof(header));
+
+    // entries are aligned since mapping is page aligned
+    const size_t maxCount = (size - sizeof(header)) / sizeof(SymbolCacheEntry);
+    const size_t namesOffset = sizeof(header) + (size_t(header.count) * sizeof(SymbolCacheEntry));
+    bool valid = memcmp(header.magic, KT_SYMBOL_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+                 header.count <= maxCount && namesOffset + header.namesSize == size;
+
+    const auto *entries = (const SymbolCacheEntry *)(base + sizeof(header));
+    const char *names = base + namesOffset;
+
+    symbols.symbols.reserve(valid ? header.count : 0);
+    for (uint32_t i = 0; valid && i < header.count; i++)
+    {
+        const SymbolCacheEntry &entry = entries[i];
+        if (uint64_t(entry.name) + entry.nameLength >= header.namesSize)
+        {
+            valid = false;
+            break;
+        }
+
+        symbols.symbols.emplace_back(d.loadBias + uintptr_t(entry.offset), std::string_view(names + entry.name, entry.nameLength));
+    }
+
+    if (!valid)
+    {
+        KITTY_LOGD("ElfScanner: invalid symbol cache %s.", path.c_str());
+        symbols.symbols.clear();
+        symbols.cacheMap.reset();
+    }
+
+    return valid;
+}
+
+bool ElfScanner::storeSymbolCache(const std::string &path, const SymbolsData &symbols) const
+{
+    const ElfData &d = *_data;
+
+    std::vector<SymbolCacheEntry> entries;
+    entries.reserve(symbols.symbols.size());
+    std::string names;
+    for (auto &it : symbols.symbols)
+    {
+        entries.push_back({uint64_t(it.first - d.loadBias), uint32_t(names.size()), uint32_t(it.second.size())});
+        names.append(it.second);
+        names.push_back(0);
+    }
+
+    SymbolCacheHeader header{};
+    memcpy(header.magic, KT_SYMBOL_CACHE_MAGIC, sizeof(header.magic));
+    header.count = uint32_t(entries.size());
+    header.namesSize = uint32_t(names.size());
+
+    mkdir(d.symbolCacheDir.c_str(), 0755);
+
+    // written aside & renamed so readers never map a partial file
+    const std::string tmpPath = path + "." + std::to_string(getpid()) + ".tmp";
+    KittyIOFile file(tmpPath, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+    if (!file.Open())
+        return false;
+
+    const size_t entriesSize = entries.size() * sizeof(SymbolCacheEntry);
+    bool ok = file.Write(0, &header, sizeof(header)) == ssize_t(sizeof(header)) &&
+              file.Write(sizeof(header), entries.data(), entriesSize) == ssize_t(entriesSize) &&
+              file.Write(sizeof(header) + entriesSize, names.data(), names.size()) == ssize_t(names.size());
+
+    file.Close();
+
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool ElfScanner::readSymbolIfName(uint32_t index, const std::string &symbolName, ElfW_(Sym) * sym) const
+{
+    const ElfData &d = *_data;
+
+    if (!d.pMem->Read(d.symbolTable + (uintptr_t(index) * d.syment), sym, sizeof(ElfW_(Sym))))
+        return false;
+
+    if (!sym->st_name || !sym->st_value || sym->st_name + symbolName.length() >= d.strsz)
+        return false;
+
+    // name & its null terminator
+    char name[256];
+    std::vector<char> longName;
+    char *buf = name;
+    if (symbolName.length() + 1 > sizeof(name))
+    {
+        longName.resize(symbolName.length() + 1);
+        buf = longName.data();
+    }
+
+    if (d.pMem->Read(d.stringTable + sym->st_name, buf, symbolName.length() + 1) != symbolName.length() + 1)
+        return false;
+
+    return buf[symbolName.length()] == 0 && memcmp(buf, symbolName.data(), symbolName.length()) == 0;
+}
+
+uintptr_t ElfScanner::findSymbolGnuHash(const std::string &symbolName) const
+{
+    const ElfData &d = *_data;
+
+    uint32_t hash = 5381;
+    for (unsigned char c : symbolName)
+        hash = (hash << 5) + hash + c;
+
+    const uintptr_t bloomAddr = d.gnuHash + 16;
+    const uintptr_t bucketsAddr = bloomAddr + (uintptr_t(d.gnuBloomSize) * sizeof(ElfW_(Addr)));
+    const uintptr_t chainsAddr = bucketsAddr + (uintptr_t(d.gnuNBuckets) * sizeof(uint32_t));
+
+    // bloom filter rejects most missing symbols with one read
+    ElfW_(Addr) bloomWord = 0;
+    const uint32_t bloomIndex = (hash / ELFCLASS_BITS_) % d.gnuBloomSize;
+    if (!d.pMem->Read(bloomAddr + (bloomIndex * sizeof(ElfW_(Addr))), &bloomWord, sizeof(bloomWord)))
+        return 0;
+
+    const ElfW_(Addr) bloomMask = (ElfW_(Addr)(1) << (hash % ELFCLASS_BITS_)) |
+                                  (ElfW_(Addr)(1) << ((hash >> d.gnuBloomShift) % ELFCLASS_BITS_));
+    if ((bloomWord & bloomMask) != bloomMask)
+        return 0;
+
+    uint32_t symIndex = 0;
+    if (!d.pMem->Read(bucketsAddr + ((hash % d.gnuNBuckets) * sizeof(uint32_t)), &symIndex, sizeof(symIndex)) ||
+        symIndex < d.gnuSymOffset)
+        return 0;
+
+    // chain values are read in small blocks, last entry of a chain has the low bit set
+    uint32_t chain[16];
+    size_t chainCount = 0, chainPos = 0;
+    for (;; symIndex++, chainPos++)
+    {
+        if (chainPos >= chainCount)
+        {
+            chainPos = 0;
+            chainCount = d.pMem->Read(chainsAddr + (uintptr_t(symIndex - d.gnuSymOffset) * sizeof(uint32_t)), chain, sizeof(chain)) / sizeof(uint32_t);
+            if (!chainCount)
+                return 0;
+        }
+
+        const uint32_t chainHash = chain[chainPos];
+
+        ElfW_(Sym) sym{};
+        if ((chainHash | 1) == (hash | 1) && readSymbolIfName(symIndex, symbolName, &sym))
+            return symbolAddress(sym);
+
+        if (chainHash & 1)
+            break;
+    }
+
+    return 0;
+}
+
+uintptr_t ElfScanner::findSymbolSysvHash(const std::string &symbolName) const
 {
-    if (_symbols.empty())
+    const ElfData &d = *_data;
+
+    uint32_t hash = 0;
+    for (unsigned char c : symbolName)
+    {
+        hash = (hash << 4) + c;
+        uint32_t g = hash & 0xf0000000;
+        if (g)
+            hash ^= g >> 24;
+        hash &= ~g;
+    }
+
+    const uintptr_t bucketsAddr = d.sysvHash + 8;
+    const uintptr_t chainsAddr = bucketsAddr + (uintptr_t(d.sysvNBuckets) * sizeof(uint32_t));
+
+    uint32_t symIndex = 0;
+    if (!d.pMem->Read(bucketsAddr + ((hash % d.sysvNBuckets) * sizeof(uint32_t)), &symIndex, sizeof(symIndex)))
         return 0;
 
-    for (auto &sym : _symbols)
-        if (!sym.second.empty() && sym.second == symbolName)
-            return sym.first;
+    // bounded by chain count in case of a corrupted table
+    for (uint32_t steps = 0; symIndex != STN_UNDEF && symIndex < d.sysvNChains && steps < d.sysvNChains; steps++)
+    {
+        ElfW_(Sym) sym{};
+        if (readSymbolIfName(symIndex, symbolName, &sym))
+            return symbolAddress(sym);
+
+        if (!d.pMem->Read(chainsAddr + (uintptr_t(symIndex) * sizeof(uint32_t)), &symIndex, sizeof(symIndex)))
+            break;
+    }
 
     return 0;
-}
\ No newline at end of file
+}
+
+uintptr_t ElfScanner::findSymbol(const std::string &symbolName) const
+{
+    if (!isValid() || symbolName.empty())
+        return 0;
+
+    const ElfData &d = *_data;
+
+    // symbols already read, no remote reads needed
+    if (d.symbols.ready.load(std::memory_order_acquire))
+    {
+        auto it = d.symbols.index.find(symbolName);
+        return it != d.symbols.index.end() ? it->second : 0;
+    }
+
+    uintptr_t address = 0;
+    if (d.gnuHash)
+        address = findSymbolGnuHash(symbolName);
+    else if (d.sysvHash)
+        address = findSymbolSysvHash(symbolName);
+
+    // hash tables only cover dynamic symbols
+    if (address || ((d.gnuHash || d.sysvHash) && d.filePath.empty()))
+        return address;
+
+    auto symbols = symbolsData();
+    if (!symbols)
+        return 0;
+
+    auto it = symbols->index.find(symbolName);
+    return it != symbols->index.end() ? it->second : 0;
+}
+
+// GOT relocation of non PLT imports
+#if defined(__aarch64__)
+#define KT_R_GLOB_DAT R_AARCH64_GLOB_DAT
+#elif defined(__arm__)
+#define KT_R_GLOB_DAT R_ARM_GLOB_DAT
+#elif defined(__i386__)
+#define KT_R_GLOB_DAT R_386_GLOB_DAT
+#elif defined(__x86_64__)
+#define KT_R_GLOB_DAT R_X86_64_GLOB_DAT
+#else
+#error "Unsupported ABI"
+#endif
+
+void ElfScanner::readImports(ImportsData &imports) const
+{
+    const ElfData &d = *_data;
+
+    // slot address & symbol index
+    std::vector<std::pair<uintptr_t, uint32_t>> relocs;
+    uint32_t maxSymIndex = 0;
+
+    auto readRelocs = [&](uintptr_t table, size_t size, size_t entsize, bool isRela, bool isPlt)
+    {
+        // Rel is the start of Rela
+        const size_t relocSize = isRela ? sizeof(ElfW_(Rela)) : sizeof(ElfW_(Rel));
+        if (!entsize)
+            entsize = relocSize;
+
+        if (!table || !size || entsize < sizeof(ElfW_(Rel)) || size > d.loadSize)
+            return;
+
+        std::vector<char> buf(size);
+        const size_t count = d.pMem->Read(table, buf.data(), buf.size()) / entsize;
+        for (size_t i = 0; i < count; i++)
+        {
+            ElfW_(Rela) reloc{};
+            memcpy(&reloc, buf.data() + (i * entsize), std::min(entsize, relocSize));
+
+            const uint32_t symIndex = uint32_t(ELFW_(R_SYM)(reloc.r_info));
+            if (!symIndex || (!isPlt && ELFW_(R_TYPE)(reloc.r_info) != KT_R_GLOB_DAT))
+                continue;
+
+            const uintptr_t slot = reloc.r_offset < d.loadBias ? d.loadBias + reloc.r_offset : reloc.r_offset;
+            relocs.emplace_back(slot, symIndex);
+            maxSymIndex = std::max(maxSymIndex, symIndex);
+        }
+    };
+
+    // PLT slots first so they win in the index
+    const bool pltRela = d.pltrel ? d.pltrel == DT_RELA : (d.rela && !d.rel);
+    readRelocs(d.jmprel, d.pltrelsz, pltRela ? d.relaent : d.relent, pltRela, true);
+    readRelocs(d.rela, d.relasz, d.relaent, true, false);
+    readRelocs(d.rel, d.relsz, d.relent, false, false);
+
+    if (relocs.empty())
+        return;
+
+    if ((size_t(maxSymIndex) + 1) > d.loadSize / d.syment || d.strsz > d.loadSize)
+    {
+        KITTY_LOGD("ElfScanner: invalid imports symbols size of ELF (%p).", (void *)d.elfBase);
+        return;
+    }
+
+    // only symbols up to the highest referenced one
+    std::vector<char> symtab((size_t(maxSymIndex) + 1) * d.syment);
+    const size_t symCount = d.pMem->Read(d.symbolTable, symtab.data(), symtab.size()) / d.syment;
+
+    std::vector<char> &strtab = imports.strtab;
+    strtab.assign(d.strsz + 1, 0);
+    const size_t strsz = d.pMem->Read(d.stringTable, strtab.data(), d.strsz);
+    if (!symCount || !strsz)
+    {
+        KITTY_LOGD("ElfScanner: failed to read import symbols of ELF (%p).", (void *)d.elfBase);
+        return;
+    }
+
+    imports.imports.reserve(relocs.size());
+    imports.index.reserve(relocs.size());
+    for (auto &it : relocs)
+    {
+        if (it.second >= symCount)
+            continue;
+
+        ElfW_(Sym) sym{};
+        memcpy(&sym, symtab.data() + (size_t(it.second) * d.syment), std::min(d.syment, sizeof(sym)));
+        if (!sym.st_name || sym.st_name >= strsz)
+            continue;
+
+        const char *name = strtab.data() + sym.st_name;
+        const size_t len = strnlen(name, strsz - sym.st_name);
+        if (!len)
+            continue;
+
+        const std::string_view symName(name, len);
+        imports.imports.emplace_back(it.first, symName);
+        imports.index.emplace(symName, it.first);
+    }
+}
+
+const ElfScanner::ImportsData *ElfScanner::importsData() const
+{
+    if (!isValid())
+        return nullptr;
+
+    ImportsData &imports = _data->imports;
+    std::call_once(imports.once, [&]
+                   { readImports(imports); });
+    return &imports;
+}
+
+const std::vector<std::pair<uintptr_t, std::string_view>> &ElfScanner::imports() const
+{
+    auto imports = importsData();
+    return imports ? imports->imports : emptyData().imports.imports;
+}
+
+uintptr_t ElfScanner::findImport(const std::string &symbolName) const
+{
+    if (symbolName.empty())
+        return 0;
+
+    auto imports = importsData();
+    if (!imports)
+        return 0;
+
+    auto it = imports->index.find(symbolName);
+    return it != imports->index.end() ? it->second : 0;
+}
+
+ElfScanner ElfScannerMgr::createWithBase(uintptr_t elfBase) const
+{
+    if (!_pMem)
+        return ElfScanner();
+
+    std::string filePath;
+    if (_fileSymbols)
+        filePath = KittyMemoryEx::getAddressMap(_pMem->remotePID(), elfBase).pathname;
+
+    return ElfScanner(_pMem, elfBase, true, _symbolCacheDir, filePath);
+}
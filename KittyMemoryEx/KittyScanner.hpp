@@ -3,15 +3,175 @@
 #include "KittyUtils.hpp"
 #include "KittyMemoryEx.hpp"
 #include "KittyMemOp.hpp"
+#include "KittyPattern.hpp"
+#include "KittyThreadPool.hpp"
+
+// default size of a scan window buffer
+#define KT_SCAN_CHUNK_SIZE (1024 * 1024)
+
+// max bytes of a PT_NOTE segment read when looking for the build-id
+#define KT_ELF_NOTES_MAX_SIZE 0x1000
+
+/**
+ * Selects the maps covered by a multi region scan
+ */
+struct KittyMapFilter
+{
+    // required protection flags
+    int protection;
+    // only maps without pathname
+    bool anonymousOnly;
+    // optional extra predicate, e.g. on pathname
+    std::function<bool(const KittyMemoryEx::ProcMap &)> predicate;
+
+    KittyMapFilter() : protection(PROT_READ), anonymousOnly(false) {}
+    explicit KittyMapFilter(int protection, bool anonymousOnly = false,
+                            std::function<bool(const KittyMemoryEx::ProcMap &)> predicate = nullptr)
+        : protection(protection), anonymousOnly(anonymousOnly), predicate(std::move(predicate)) {}
+
+    inline bool matches(const KittyMemoryEx::ProcMap &map) const
+    {
+        return map.isValid() && (map.protection & protection) == protection &&
+               (!anonymousOnly || map.isUnknown()) && (!predicate || predicate(map));
+    }
+};
 
 class KittyScannerMgr
 {
 private:
     IKittyMemOp *_pMem;
+    size_t _chunkSize;
+    bool _doubleBuffering;
+    std::shared_ptr<KittyThreadPool> _threadPool;
+
+    // regions of the filtered maps split into work items
+    struct ScanItem
+    {
+        size_t map;
+        uintptr_t start, end, mapEnd;
+    };
+    std::vector<ScanItem> splitMaps(const std::vector<KittyMemoryEx::ProcMap> &maps) const;
+    std::shared_ptr<KittyThreadPool> threadPool() const;
+
+    /**
+     * Called for each readable run of a scan window
+     *
+     * @param remote: remote address of run
+     * @param data: local copy of run
+     * @param size: run size
+     * @param reportSize: only matches starting before this offset belong to this window
+     *
+     * @return false to stop scanning
+     */
+    using ScanRunCallback = std::function<bool(uintptr_t remote, const char *data, size_t size, size_t reportSize)>;
+
+    /**
+     * Stream a memory range in windows of chunkSize + overlap bytes reusing the same buffers,
+     * consecutive windows overlap by (overlap) bytes so matches crossing a chunk border are not missed.
+     *
+     * @param maps: optional maps sorted by address used to skip unreadable pages of a window, parsed again if null
+     *
+     * @return false if nothing could be read
+     */
+    bool streamRange(uintptr_t start, uintptr_t end, size_t overlap, const ScanRunCallback &cb,
+                     const std::vector<KittyMemoryEx::ProcMap> *maps = nullptr) const;
+
+    /**
+     * Single pass multi pattern scan, candidates are found by bucketing patterns on their anchor byte
+     *
+     * @param onFound: called for each match with pattern id & remote address, return false to stop scanning
+     * @param firstOnly: report only the first match of each pattern
+     */
+    void scanMany(uintptr_t start, uintptr_t end, const std::vector<KittyPattern> &patterns, bool firstOnly,
+                  const std::function<bool(size_t id, uintptr_t address)> &onFound) const;
 
 public:
-    KittyScannerMgr() : _pMem(nullptr) {}
-    KittyScannerMgr(IKittyMemOp *pMem) : _pMem(pMem) {}
+    KittyScannerMgr() : _pMem(nullptr), _chunkSize(KT_SCAN_CHUNK_SIZE), _doubleBuffering(false) {}
+    KittyScannerMgr(IKittyMemOp *pMem) : _pMem(pMem), _chunkSize(KT_SCAN_CHUNK_SIZE), _doubleBuffering(false) {}
+
+    inline size_t chunkSize() const { return _chunkSize; }
+
+    /**
+     * Set scan window size, memory used by a scan is bounded by this regardless of range size
+     */
+    inline void setChunkSize(size_t size) { _chunkSize = std::max<size_t>(size, KT_PAGE_SIZE); }
+
+    inline bool doubleBuffering() const { return _doubleBuffering; }
+
+    /**
+     * Read next scan window on another thread while the current one is being matched
+     */
+    inline void setDoubleBuffering(bool flag) { _doubleBuffering = flag; }
+
+    /**
+     * Worker pool used by multi region scans, KittyThreadPool::shared() is used if not set
+     */
+    inline void setThreadPool(std::shared_ptr<KittyThreadPool> pool) { _threadPool = std::move(pool); }
+
+    /**
+     * Scan all maps matching filter in parallel and return all results ordered by address
+     *
+     * @param filter: selects scanned maps
+     * @param pattern: precompiled pattern
+     *
+     * @return vector list of all found pattern addresses
+     */
+    std::vector<uintptr_t> findPatternAllInMaps(const KittyMapFilter &filter, const KittyPattern &pattern) const;
+
+    /**
+     * Scan all maps matching filter in parallel and return the lowest found address
+     *
+     * @param filter: selects scanned maps
+     * @param pattern: precompiled pattern
+     *
+     * @return first found pattern address
+     */
+    uintptr_t findPatternFirstInMaps(const KittyMapFilter &filter, const KittyPattern &pattern) const;
+
+    /**
+     * Search for a precompiled pattern within a memory range and return all results
+     *
+     * @param start: search start address
+     * @param end: search end address
+     * @param pattern: precompiled pattern, see KittyPattern::fromIDA & KittyPatternLiteral
+     *
+     * @return vector list of all found pattern addresses
+     */
+    std::vector<uintptr_t> findPatternAll(const uintptr_t start, const uintptr_t end, const KittyPattern &pattern) const;
+
+    /**
+     * Search for a precompiled pattern within a memory range and return first result
+     *
+     * @param start: search start address
+     * @param end: search end address
+     * @param pattern: precompiled pattern, see KittyPattern::fromIDA & KittyPatternLiteral
+     *
+     * @return first found pattern address
+     */
+    uintptr_t findPatternFirst(const uintptr_t start, const uintptr_t end, const KittyPattern &pattern) const;
+
+    /**
+     * Search for multiple patterns within a memory range in a single pass and return all results
+     *
+     * @param start: search start address
+     * @param end: search end address
+     * @param patterns: precompiled patterns, pattern id is its index
+     *
+     * @return vector list of all found addresses for each pattern id
+     */
+    std::vector<std::vector<uintptr_t>> findManyAll(const uintptr_t start, const uintptr_t end, const std::vector<KittyPattern> &patterns) const;
+
+    /**
+     * Search for multiple patterns within a memory range in a single pass and return first result of each,
+     * scanning stops once all patterns are found
+     *
+     * @param start: search start address
+     * @param end: search end address
+     * @param patterns: precompiled patterns, pattern id is its index
+     *
+     * @return first found address for each pattern id, 0 if not found
+     */
+    std::vector<uintptr_t> findManyFirst(const uintptr_t start, const uintptr_t end, const std::vector<KittyPattern> &patterns) const;
 
     /**
      * Search for bytes within a memory range and return all results
@@ -91,51 +251,188 @@ class ElfScanner
     friend class ElfScannerMgr;
 
 private:
-    IKittyMemOp *_pMem;
-    uintptr_t _elfBase;
-    ElfW_(Ehdr) _ehdr;
-    std::vector<ElfW_(Phdr)> _phdrs;
-    int _loads;
-    uintptr_t _loadBias, _loadSize;
-    std::vector<ElfW_(Dyn)> _dynamics;
-    uintptr_t _stringTable, _symbolTable;
-    size_t _strsz, _syment;
-    std::vector<std::pair<uintptr_t, std::string>> _symbols;
+    // symbol tables, read once on first use
+    struct SymbolsData
+    {
+        std::once_flag once;
+        // set once symbols & index are filled
+        std::atomic<bool> ready;
+        // names point into strtab
+        std::vector<char> strtab;
+        std::vector<std::pair<uintptr_t, std::string_view>> symbols;
+        // name -> address of its first symbol
+        std::unordered_map<std::string_view, uintptr_t> index;
+        // symbol cache file mapping, names point into it instead of strtab when loaded from cache
+        std::shared_ptr<void> cacheMap;
+        // backing file mapping, .symtab names point into it
+        std::shared_ptr<void> fileMap;
+
+        SymbolsData() : ready(false) {}
+    };
+
+    // import relocations, read once on first use
+    struct ImportsData
+    {
+        std::once_flag once;
+        // names point into strtab
+        std::vector<char> strtab;
+        std::vector<std::pair<uintptr_t, std::string_view>> imports;
+        // name -> first slot, PLT slots come first
+        std::unordered_map<std::string_view, uintptr_t> index;
+    };
+
+    // parsed ELF, immutable after construction except for the lazily read symbols & imports
+    struct ElfData
+    {
+        IKittyMemOp *pMem;
+        uintptr_t elfBase;
+        ElfW_(Ehdr) ehdr;
+        std::vector<ElfW_(Phdr)> phdrs;
+        int loads;
+        uintptr_t loadBias, loadSize;
+        std::vector<ElfW_(Dyn)> dynamics;
+        uintptr_t stringTable, symbolTable;
+        size_t strsz, syment;
+
+        // DT_GNU_HASH & DT_HASH tables, 0 if missing
+        uintptr_t gnuHash, sysvHash;
+        uint32_t gnuNBuckets, gnuSymOffset, gnuBloomSize, gnuBloomShift;
+        uint32_t sysvNBuckets, sysvNChains;
+
+        // DT_JMPREL & DT_RELA / DT_REL tables, 0 if missing
+        uintptr_t jmprel, rela, rel;
+        size_t pltrelsz, relasz, relsz, relaent, relent;
+        // DT_PLTREL, type of DT_JMPREL entries
+        int pltrel;
+
+        // NT_GNU_BUILD_ID note as hex, empty if missing
+        std::string buildId;
+        // directory of symbol cache files, empty to disable
+        std::string symbolCacheDir;
+        // on-disk file to read .symtab from, empty to disable
+        std::string filePath;
+
+        mutable SymbolsData symbols;
+        mutable ImportsData imports;
+
+        ElfData() : pMem(nullptr), elfBase(0), ehdr{}, loads(0), loadBias(0), loadSize(0),
+                    stringTable(0), symbolTable(0), strsz(0), syment(0),
+                    gnuHash(0), sysvHash(0), gnuNBuckets(0), gnuSymOffset(0), gnuBloomSize(0), gnuBloomShift(0),
+                    sysvNBuckets(0), sysvNChains(0),
+                    jmprel(0), rela(0), rel(0), pltrelsz(0), relasz(0), relsz(0), relaent(0), relent(0), pltrel(0) {}
+    };
+
+    // shared by all copies, copying a scanner only bumps the ref count
+    std::shared_ptr<const ElfData> _data;
+
+    // data of default constructed scanners
+    static const ElfData &emptyData();
+
+    inline const ElfData &data() const { return _data ? *_data : emptyData(); }
+
+    inline uintptr_t symbolAddress(const ElfW_(Sym) & sym) const
+    {
+        return sym.st_value < _data->loadBias ? _data->loadBias + sym.st_value : sym.st_value;
+    }
+
+    // reads symbol at index & compares its name
+    bool readSymbolIfName(uint32_t index, const std::string &symbolName, ElfW_(Sym) * sym) const;
+
+    uintptr_t findSymbolGnuHash(const std::string &symbolName) const;
+    uintptr_t findSymbolSysvHash(const std::string &symbolName) const;
+
+    // number of dynamic symbols from hash tables, 0 if unknown
+    size_t dynamicSymbolCount() const;
+
+    // bulk read dynsym & dynstr, false if tables were not fully read
+    bool readDynamicSymbols(SymbolsData &symbols) const;
+
+    // map backing file & add its .symtab symbols missing from dynsym
+    void readFileSymbols(SymbolsData &symbols) const;
+
+    // from cache if possible, otherwise read from memory & cached, then merged with file symbols
+    void readSymbols(SymbolsData &symbols) const;
+
+    // cache file of this ELF, empty if cache is disabled or ELF has no build-id
+    std::string symbolCachePath() const;
+    bool loadSymbolCache(const std::string &path, SymbolsData &symbols) const;
+    bool storeSymbolCache(const std::string &path, const SymbolsData &symbols) const;
+
+    const SymbolsData *symbolsData() const;
+
+    // bulk read relocation tables & names of their symbols
+    void readImports(ImportsData &imports) const;
+
+    const ImportsData *importsData() const;
 
 public:
-    ElfScanner() : _pMem(nullptr), _elfBase(0), _loads(0), _loadBias(0), _loadSize(0),
-                   _stringTable(0), _symbolTable(0), _strsz(0), _syment(0) {}
-    ElfScanner(IKittyMemOp *pMem, uintptr_t elfBase);
+    ElfScanner() {}
+    /**
+     * @param lazySymbols: only read headers & dynamics, symbol tables are read on first symbols() call
+     * or when findSymbol can't use a hash table
+     * @param symbolCacheDir: directory where symbols are cached by build-id, empty to disable.
+     * cached symbols are loaded with a single mmap instead of reading the tables from memory
+     * @param filePath: on-disk file of this ELF, its .symtab symbols (static & local) are merged with dynamic ones,
+     * empty to only use dynamic symbols
+     */
+    ElfScanner(IKittyMemOp *pMem, uintptr_t elfBase, bool lazySymbols = true, const std::string &symbolCacheDir = "",
+               const std::string &filePath = "");
 
     inline bool isValid() const
     {
-        return _loads && !_phdrs.empty() && _loadBias && _loadSize &&
-               !_dynamics.empty() && _stringTable && _symbolTable && _strsz && _syment;
+        const ElfData &d = data();
+        return d.loads && !d.phdrs.empty() && d.loadBias && d.loadSize &&
+               !d.dynamics.empty() && d.stringTable && d.symbolTable && d.strsz && d.syment;
     }
 
-    inline ElfW_(Ehdr) header() const { return _ehdr; }
+    inline const ElfW_(Ehdr) & header() const { return data().ehdr; }
+
+    inline const std::vector<ElfW_(Phdr)> &programHeaders() const { return data().phdrs; }
+
+    inline int loads() const { return data().loads; }
 
-    inline std::vector<ElfW_(Phdr)> programHeaders() const { return _phdrs; }
+    inline uintptr_t loadBias() const { return data().loadBias; }
 
-    inline int loads() const { return _loads; }
+    inline uintptr_t loadSize() const { return data().loadSize; }
 
-    inline uintptr_t loadBias() const { return _loadBias; }
+    inline const std::vector<ElfW_(Dyn)> &dynamics() const { return data().dynamics; }
 
-    inline uintptr_t loadSize() const { return _loadSize; }
+    inline uintptr_t stringTable() const { return data().stringTable; }
 
-    inline std::vector<ElfW_(Dyn)> dynamics() const { return _dynamics; }
+    inline uintptr_t symbolTable() const { return data().symbolTable; }
 
-    inline uintptr_t stringTable() const { return _stringTable; }
+    inline size_t stringTableSize() const { return data().strsz; }
 
-    inline uintptr_t symbolTable() const { return _symbolTable; }
+    inline size_t symbolEntrySize() const { return data().syment; }
 
-    inline size_t stringTableSize() const { return _strsz; }
+    // GNU build-id as hex, empty if ELF has no NT_GNU_BUILD_ID note
+    inline const std::string &buildId() const { return data().buildId; }
 
-    inline size_t symbolEntrySize() const { return _syment; }
+    // on-disk file .symtab symbols are read from, empty if disabled
+    inline const std::string &filePath() const { return data().filePath; }
 
-    inline std::vector<std::pair<uintptr_t, std::string>> symbols() const { return _symbols; }
+    /**
+     * (address, name) of dynamic & file symbols, read on first use.
+     * Names are views into data shared by copies of this scanner, they dangle once the last copy is gone,
+     * e.g. symbols() of a temporary like getElfBaseMap(...).elfScan, keep a copy of the scanner
+     * or copy names into std::string to outlive it.
+     */
+    const std::vector<std::pair<uintptr_t, std::string_view>> &symbols() const;
+
+    inline uintptr_t gnuHashTable() const { return data().gnuHash; }
+
+    inline uintptr_t sysvHashTable() const { return data().sysvHash; }
+
+    // (GOT slot address, symbol name) of PLT relocations in DT_JMPREL & GLOB_DAT relocations in DT_RELA / DT_REL,
+    // read on first use, names are views that dangle once the last copy of this scanner is gone like symbols()
+    const std::vector<std::pair<uintptr_t, std::string_view>> &imports() const;
+
+    // returns the GOT slot address holding the resolved address of an imported symbol, PLT slot first
+    uintptr_t findImport(const std::string &symbolName) const;
 
     // retuns the absolute address of symbol
+    // uses the symbols index once symbols are read, otherwise resolved through DT_GNU_HASH or DT_HASH chains
+    // when available so only a few symbols are read, symbols not found there are looked up in file symbols if enabled
     uintptr_t findSymbol(const std::string &symbolName) const;
 };
 
@@ -143,17 +440,30 @@ class ElfScannerMgr
 {
 private:
     IKittyMemOp *_pMem;
+    std::string _symbolCacheDir;
+    bool _fileSymbols;
 
 public:
-    ElfScannerMgr() : _pMem(nullptr) {}
-    ElfScannerMgr(IKittyMemOp *pMem) : _pMem(pMem) {}
+    ElfScannerMgr() : _pMem(nullptr), _fileSymbols(false) {}
+    ElfScannerMgr(IKittyMemOp *pMem) : _pMem(pMem), _fileSymbols(false) {}
+
+    /**
+     * Cache symbols of created scanners in dir by ELF build-id, empty to disable
+     */
+    inline void setSymbolCacheDir(const std::string &dir) { _symbolCacheDir = dir; }
+    inline const std::string &symbolCacheDir() const { return _symbolCacheDir; }
+
+    /**
+     * Merge .symtab symbols of the on-disk file of created scanners, found from the map pathname
+     */
+    inline void setFileSymbols(bool enable) { _fileSymbols = enable; }
+    inline bool fileSymbols() const { return _fileSymbols; }
+
+    ElfScanner createWithBase(uintptr_t elfBase) const;
 
-    inline ElfScanner createWithBase(uintptr_t elfBase) const
-    {
-        return !_pMem ? ElfScanner() : ElfScanner(_pMem, elfBase);
-    }
     inline ElfScanner createWithMap(const KittyMemoryEx::ProcMap &map) const
     {
-        return !_pMem ? ElfScanner() : ElfScanner(_pMem, map.startAddress);
+        return !_pMem ? ElfScanner() : ElfScanner(_pMem, map.startAddress, true, _symbolCacheDir,
+                                                  _fileSymbols ? map.pathname : "");
     }
 };
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "KittyThreadPool.hpp"
+
+// pool owning the current thread, null outside workers
+static thread_local const KittyThreadPool *s_currentPool = nullptr;
+
+KittyThreadPool::KittyThreadPool(size_t nThreads) : _task(nullptr), _generation(0), _active(0), _pending(0), _stop(false)
+{
+    if (!nThreads)
+        nThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 0; i < nThreads; i++)
+        _queues.push_back(std::make_unique<WorkQueue>());
+
+    for (size_t i = 0; i < nThreads; i++)
+        _threads.emplace_back(&KittyThreadPool::workerLoop, this, i);
+}
+
+KittyThreadPool::~KittyThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _stop = true;
+    }
+    _wake.notify_all();
+
+    for (auto &it : _threads)
+    {
+        if (it.joinable())
+            it.join();
+    }
+}
+
+bool KittyThreadPool::popItem(size_t worker, size_t &item)
+{
+    // own queue first, in order
+    {
+        WorkQueue &own = *_queues[worker];
+        std::lock_guard<std::mutex> lock(own.lock);
+        if (!own.items.empty())
+        {
+            item = own.items.front();
+            own.items.pop_front();
+            return true;
+        }
+    }
+
+    // steal from the back of other queues
+    for (size_t i = 1; i < _queues.size(); i++)
+    {
+        WorkQueue &victim = *_queues[(worker + i) % _queues.size()];
+        std::lock_guard<std::mutex> lock(victim.lock);
+        if (!victim.items.empty())
+        {
+            item = victim.items.back();
+            victim.items.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void KittyThreadPool::workerLoop(size_t worker)
+{
+    s_currentPool = this;
+
+    size_t lastGeneration = 0;
+    while (true)
+    {
+        const std::function<void(size_t)> *task = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            _wake.wait(lock, [&]
+                       { return _stop || _generation != lastGeneration; });
+
+            if (_stop)
+                return;
+
+            lastGeneration = _generation;
+            task = _task;
+            _active++;
+        }
+
+        size_t item = 0;
+        while (task && popItem(worker, item))
+        {
+            (*task)(item);
+            _pending--;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _active--;
+        }
+        _idle.notify_all();
+    }
+}
+
+std::shared_ptr<KittyThreadPool> KittyThreadPool::shared()
+{
+    static std::shared_ptr<KittyThreadPool> pool = std::make_shared<KittyThreadPool>();
+    return pool;
+}
+
+void KittyThreadPool::run(size_t count, const std::function<void(size_t index)> &task)
+{
+    if (!count || !task)
+        return;
+
+    // nested run from one of our workers, the pool is busy with the outer run
+    if (s_currentPool == this)
+    {
+        for (size_t i = 0; i < count; i++)
+            task(i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> runLock(_runLock);
+
+    // contiguous blocks per worker keep neighbouring items on the same thread
+    const size_t nQueues = _queues.size();
+    const size_t perQueue = (count + nQueues - 1) / nQueues;
+    for (size_t i = 0; i < count; i++)
+    {
+        WorkQueue &queue = *_queues[i / perQueue];
+        std::lock_guard<std::mutex> lock(queue.lock);
+        queue.items.push_back(i);
+    }
+
+    std::unique_lock<std::mutex> lock(_lock);
+    _pending = count;
+    _task = &task;
+    _generation++;
+    _wake.notify_all();
+
+    _idle.wait(lock, [&]
+               { return _pending == 0 && _active == 0; });
+    _task = nullptr;
+}
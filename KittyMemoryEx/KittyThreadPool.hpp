@@ -0,0 +1,63 @@
+#pragma once
+
+#include "KittyUtils.hpp"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+
+/**
+ * Fixed size worker pool with per worker queues and work stealing.
+ * Idle workers steal from the back of other workers queues so uneven work items balance out.
+ */
+class KittyThreadPool
+{
+private:
+    struct WorkQueue
+    {
+        std::mutex lock;
+        std::deque<size_t> items;
+    };
+
+    std::vector<std::thread> _threads;
+    std::vector<std::unique_ptr<WorkQueue>> _queues;
+
+    std::mutex _lock;
+    // serializes run callers
+    std::mutex _runLock;
+    std::condition_variable _wake, _idle;
+    const std::function<void(size_t)> *_task;
+    size_t _generation, _active;
+    std::atomic<size_t> _pending;
+    bool _stop;
+
+    bool popItem(size_t worker, size_t &item);
+    void workerLoop(size_t worker);
+
+public:
+    /**
+     * @param nThreads: number of workers, 0 for hardware concurrency
+     */
+    explicit KittyThreadPool(size_t nThreads = 0);
+    ~KittyThreadPool();
+
+    KittyThreadPool(const KittyThreadPool &) = delete;
+    KittyThreadPool &operator=(const KittyThreadPool &) = delete;
+
+    inline size_t size() const { return _threads.size(); }
+
+    /**
+     * Process wide pool with hardware concurrency workers, created on first use,
+     * used by scanners that were not given a pool
+     */
+    static std::shared_ptr<KittyThreadPool> shared();
+
+    /**
+     * Run task(index) for each index in [0, count) on the pool and wait for all of them,
+     * concurrent callers run one after another.
+     * Called from a task of this pool, items run inline on the calling worker instead of deadlocking.
+     */
+    void run(size_t count, const std::function<void(size_t index)> &task);
+};
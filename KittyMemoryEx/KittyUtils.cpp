@@ -90,25 +90,23 @@ namespace KittyUtils
         void *data             //!< Data store
     )
     {
-        size_t length = in.length();
-        auto *byteData = reinterpret_cast<unsigned char *>(data);
-
-        std::stringstream hexStringStream;
-        hexStringStream >> std::hex;
-        for (size_t strIndex = 0, dataIndex = 0; strIndex < length; ++dataIndex)
+        auto nibble = [](char c) -> unsigned char
         {
-            // Read out and convert the string two characters at a time
-            const char tmpStr[3] = {in[strIndex++], in[strIndex++], 0};
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return 0;
+        };
 
-            // Reset and fill the string stream
-            hexStringStream.clear();
-            hexStringStream.str(tmpStr);
+        size_t length = in.length();
+        auto *byteData = reinterpret_cast<unsigned char *>(data);
 
-            // Do the conversion
-            int tmpValue = 0;
-            hexStringStream >> tmpValue;
-            byteData[dataIndex] = static_cast<unsigned char>(tmpValue);
-        }
+        // convert the string two characters at a time
+        for (size_t strIndex = 0, dataIndex = 0; strIndex + 1 < length; strIndex += 2, ++dataIndex)
+            byteData[dataIndex] = static_cast<unsigned char>((nibble(in[strIndex]) << 4) | nibble(in[strIndex + 1]));
     }
 
 }
\ No newline at end of file
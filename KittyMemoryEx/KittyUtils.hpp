@@ -21,6 +21,7 @@
 #include <vector>
 #include <utility>
 #include <map>
+#include <functional>
 
 #include <elf.h>
 #ifdef __LP64__
@@ -0,0 +1,429 @@
+#include "KittyValueScanner.hpp"
+
+#include <cmath>
+#include <type_traits>
+
+// pages read per batched syscall
+#define KT_VALUE_SCAN_BATCH_PAGES 256
+
+// calls f with a value of the scanned type
+template <typename F>
+static void dispatchType(EKittyValueType type, F &&f)
+{
+    switch (type)
+    {
+    case EK_VALUE_I8:
+        f(int8_t());
+        break;
+    case EK_VALUE_I16:
+        f(int16_t());
+        break;
+    case EK_VALUE_I32:
+        f(int32_t());
+        break;
+    case EK_VALUE_I64:
+        f(int64_t());
+        break;
+    case EK_VALUE_F32:
+        f(float());
+        break;
+    case EK_VALUE_F64:
+        f(double());
+        break;
+    }
+}
+
+template <typename T>
+static inline bool matchValue(T value, T prev, T a, T b, const KittyValueQuery &query)
+{
+    auto equal = [&](T x, T y)
+    {
+        if (std::is_floating_point<T>::value)
+            return std::fabs(double(x) - double(y)) <= query.epsilon;
+        return x == y;
+    };
+
+    switch (query.compare)
+    {
+    case EK_SCAN_EXACT:
+        return equal(value, a);
+    case EK_SCAN_BETWEEN:
+        return value >= a && value <= b;
+    case EK_SCAN_GREATER:
+        return value > a;
+    case EK_SCAN_LESS:
+        return value < a;
+    case EK_SCAN_UNKNOWN:
+        return true;
+    case EK_SCAN_CHANGED:
+        return !equal(value, prev);
+    case EK_SCAN_UNCHANGED:
+        return equal(value, prev);
+    case EK_SCAN_INCREASED:
+        return value > prev;
+    case EK_SCAN_DECREASED:
+        return value < prev;
+    case EK_SCAN_INCREASED_BY:
+        return equal(value, T(prev + a));
+    case EK_SCAN_DECREASED_BY:
+        return equal(value, T(prev - a));
+    }
+    return false;
+}
+
+template <typename T>
+static inline T queryOperand(int64_t i, double f)
+{
+    return std::is_floating_point<T>::value ? T(f) : T(i);
+}
+
+// sets bitmap bits & appends values of matching slots, returns number of matches
+template <typename T>
+static size_t scanPageFirst(const uint8_t *page, size_t pageSize, size_t alignment, const KittyValueQuery &query,
+                            uint64_t *bitmap, std::vector<uint8_t> &values)
+{
+    const T a = queryOperand<T>(query.i1, query.f1), b = queryOperand<T>(query.i2, query.f2);
+
+    // every slot is kept, copy the whole page
+    if (query.compare == EK_SCAN_UNKNOWN && alignment == sizeof(T))
+    {
+        const size_t slots = pageSize / sizeof(T);
+        for (size_t slot = 0; slot < slots; slot++)
+            bitmap[slot / 64] |= 1ull << (slot % 64);
+
+        values.insert(values.end(), page, page + (slots * sizeof(T)));
+        return slots;
+    }
+
+    size_t found = 0;
+    for (size_t slot = 0, offset = 0; offset + sizeof(T) <= pageSize; slot++, offset += alignment)
+    {
+        T value;
+        memcpy(&value, page + offset, sizeof(T));
+        if (!matchValue<T>(value, value, a, b, query))
+            continue;
+
+        bitmap[slot / 64] |= 1ull << (slot % 64);
+        values.insert(values.end(), page + offset, page + offset + sizeof(T));
+        found++;
+    }
+    return found;
+}
+
+// filters bitmap bits of a page in place, previous values are read from prevIn & kept values written to valuesOut
+template <typename T>
+static size_t scanPageNext(const uint8_t *page, size_t alignment, size_t words, const KittyValueQuery &query,
+                           uint64_t *bitmap, const uint8_t *&prevIn, uint8_t *&valuesOut)
+{
+    const T a = queryOperand<T>(query.i1, query.f1), b = queryOperand<T>(query.i2, query.f2);
+
+    size_t kept = 0;
+    for (size_t w = 0; w < words; w++)
+    {
+        uint64_t bits = bitmap[w], keptBits = 0;
+        while (bits)
+        {
+            const size_t bit = __builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            T value, prev;
+            memcpy(&value, page + (((w * 64) + bit) * alignment), sizeof(T));
+            memcpy(&prev, prevIn, sizeof(T));
+            prevIn += sizeof(T);
+
+            if (!matchValue<T>(value, prev, a, b, query))
+                continue;
+
+            keptBits |= 1ull << bit;
+            memcpy(valuesOut, &value, sizeof(T));
+            valuesOut += sizeof(T);
+            kept++;
+        }
+        bitmap[w] = keptBits;
+    }
+    return kept;
+}
+
+static size_t bitmapCount(const uint64_t *bitmap, size_t words)
+{
+    size_t n = 0;
+    for (size_t w = 0; w < words; w++)
+        n += __builtin_popcountll(bitmap[w]);
+    return n;
+}
+
+KittyValueScanner::KittyValueScanner(IKittyMemOp *pMem, EKittyValueType type, size_t alignment) : KittyValueScanner()
+{
+    _pMem = pMem;
+    _type = type;
+
+    dispatchType(type, [&](auto v)
+                 { _valueSize = sizeof(v); });
+
+    _alignment = alignment ? alignment : _valueSize;
+    _pageSize = KT_PAGE_SIZE;
+    _slotsPerPage = (_pageSize - _valueSize) / _alignment + 1;
+    _wordsPerPage = (_slotsPerPage + 63) / 64;
+}
+
+void KittyValueScanner::reset()
+{
+    _pages = {};
+    _bitmaps = {};
+    _values = {};
+    _count = 0;
+    _scanned = false;
+}
+
+bool KittyValueScanner::firstScanImpl(const KittyMapFilter &filter, const KittyValueQuery &query)
+{
+    reset();
+
+    if (!_pMem || !_pageSize)
+        return false;
+
+    switch (query.compare)
+    {
+    case EK_SCAN_EXACT:
+    case EK_SCAN_BETWEEN:
+    case EK_SCAN_GREATER:
+    case EK_SCAN_LESS:
+    case EK_SCAN_UNKNOWN:
+        break;
+    default:
+        KITTY_LOGE("KittyValueScanner: compare (%d) requires a previous scan.", int(query.compare));
+        return false;
+    }
+
+    struct ScanItem
+    {
+        uintptr_t start, end;
+        std::vector<uintptr_t> pages;
+        std::vector<uint64_t> bitmaps;
+        std::vector<uint8_t> values;
+        size_t count = 0;
+    };
+
+    // split selected maps into items of a batch of pages
+    const size_t itemSize = _pageSize * KT_VALUE_SCAN_BATCH_PAGES;
+    std::vector<ScanItem> items;
+    // all maps are kept for ReadPages so faulting items don't reparse the maps file
+    const auto allMaps = KittyMemoryEx::getAllMaps(_pMem->remotePID());
+    for (auto &it : allMaps)
+    {
+        if (!filter.matches(it))
+            continue;
+
+        for (uintptr_t start = it.startAddress; start < it.endAddress; start += itemSize)
+        {
+            ScanItem item;
+            item.start = start;
+            item.end = std::min<uintptr_t>(it.endAddress, start + itemSize);
+            items.push_back(std::move(item));
+        }
+    }
+
+    auto scanItem = [&](ScanItem &item, std::vector<uint8_t> &buf)
+    {
+        std::vector<bool> valid;
+        buf.resize(item.end - item.start);
+        _pMem->ReadPages(item.start, buf.data(), buf.size(), allMaps, &valid);
+
+        for (size_t i = 0; i < valid.size(); i++)
+        {
+            if (!valid[i])
+                continue;
+
+            const size_t bitmapIndex = item.bitmaps.size();
+            item.bitmaps.resize(bitmapIndex + _wordsPerPage, 0);
+
+            size_t found = 0;
+            dispatchType(_type, [&](auto v)
+            {
+                using T = decltype(v);
+                found = scanPageFirst<T>(buf.data() + (i * _pageSize), _pageSize, _alignment, query,
+                                         item.bitmaps.data() + bitmapIndex, item.values);
+            });
+
+            if (!found)
+            {
+                item.bitmaps.resize(bitmapIndex);
+                continue;
+            }
+
+            item.pages.push_back(item.start + (i * _pageSize));
+            item.count += found;
+        }
+    };
+
+    auto mergeItem = [&](ScanItem &item)
+    {
+        _pages.insert(_pages.end(), item.pages.begin(), item.pages.end());
+        _bitmaps.insert(_bitmaps.end(), item.bitmaps.begin(), item.bitmaps.end());
+        _values.insert(_values.end(), item.values.begin(), item.values.end());
+        _count += item.count;
+        item = ScanItem();
+    };
+
+    if (!_threadPool)
+    {
+        std::vector<uint8_t> buf;
+        for (auto &item : items)
+        {
+            scanItem(item, buf);
+            mergeItem(item);
+        }
+    }
+    else
+    {
+        // scan in groups so only a few items results are held before merging
+        const size_t groupSize = _threadPool->size() * 4;
+        for (size_t group = 0; group < items.size(); group += groupSize)
+        {
+            const size_t n = std::min(groupSize, items.size() - group);
+            _threadPool->run(n, [&](size_t i)
+            {
+                std::vector<uint8_t> buf;
+                scanItem(items[group + i], buf);
+            });
+
+            for (size_t i = 0; i < n; i++)
+                mergeItem(items[group + i]);
+        }
+    }
+
+    _scanned = true;
+    return true;
+}
+
+bool KittyValueScanner::nextScanImpl(const KittyValueQuery &query)
+{
+    if (!_pMem || !_scanned)
+    {
+        KITTY_LOGE("KittyValueScanner: nextScan requires a first scan.");
+        return false;
+    }
+
+    if (query.compare == EK_SCAN_UNKNOWN)
+    {
+        KITTY_LOGE("KittyValueScanner: UNKNOWN compare is only valid for first scan.");
+        return false;
+    }
+
+    std::vector<uint8_t> buf(_pageSize * KT_VALUE_SCAN_BATCH_PAGES);
+    std::vector<KittyMemRequest> requests;
+    requests.reserve(KT_VALUE_SCAN_BATCH_PAGES);
+
+    // filter in place, outputs never overtake inputs
+    const uint8_t *prevIn = _values.data();
+    uint8_t *valuesOut = _values.data();
+    size_t outPages = 0, count = 0;
+    bool failed = false;
+
+    for (size_t batch = 0; batch < _pages.size(); batch += KT_VALUE_SCAN_BATCH_PAGES)
+    {
+        const size_t n = std::min<size_t>(KT_VALUE_SCAN_BATCH_PAGES, _pages.size() - batch);
+
+        requests.clear();
+        for (size_t i = 0; i < n; i++)
+            requests.emplace_back(_pages[batch + i], buf.data() + (i * _pageSize), _pageSize);
+
+        if (!_pMem->ReadBatch(requests.data(), requests.size()))
+        {
+            // nothing could be read, a failed read is not a changed value so keep candidates as they were
+            failed = true;
+            for (size_t i = 0; i < n; i++)
+            {
+                const size_t pageIndex = batch + i;
+                const uint64_t *bitmap = _bitmaps.data() + (pageIndex * _wordsPerPage);
+                const size_t kept = bitmapCount(bitmap, _wordsPerPage);
+
+                memmove(valuesOut, prevIn, kept * _valueSize);
+                prevIn += kept * _valueSize;
+                valuesOut += kept * _valueSize;
+
+                _pages[outPages] = _pages[pageIndex];
+                if (outPages != pageIndex)
+                    memcpy(_bitmaps.data() + (outPages * _wordsPerPage), bitmap, _wordsPerPage * sizeof(uint64_t));
+
+                outPages++;
+                count += kept;
+            }
+            continue;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            const size_t pageIndex = batch + i;
+            uint64_t *bitmap = _bitmaps.data() + (pageIndex * _wordsPerPage);
+
+            // page is gone, drop its candidates
+            if (requests[i].bytes != _pageSize)
+            {
+                prevIn += bitmapCount(bitmap, _wordsPerPage) * _valueSize;
+                continue;
+            }
+
+            size_t kept = 0;
+            dispatchType(_type, [&](auto v)
+            {
+                using T = decltype(v);
+                kept = scanPageNext<T>(buf.data() + (i * _pageSize), _alignment, _wordsPerPage, query, bitmap, prevIn, valuesOut);
+            });
+
+            if (!kept)
+                continue;
+
+            _pages[outPages] = _pages[pageIndex];
+            if (outPages != pageIndex)
+                memcpy(_bitmaps.data() + (outPages * _wordsPerPage), bitmap, _wordsPerPage * sizeof(uint64_t));
+
+            outPages++;
+            count += kept;
+        }
+    }
+
+    _pages.resize(outPages);
+    _bitmaps.resize(outPages * _wordsPerPage);
+    _values.resize(valuesOut - _values.data());
+    _count = count;
+
+    // give memory back once results narrowed down
+    if (_values.size() < _values.capacity() / 2)
+    {
+        _pages.shrink_to_fit();
+        _bitmaps.shrink_to_fit();
+        _values.shrink_to_fit();
+    }
+
+    if (failed)
+    {
+        KITTY_LOGE("KittyValueScanner: nextScan couldn't read some candidate pages, their candidates were kept.");
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<uintptr_t> KittyValueScanner::getResults(size_t maxCount) const
+{
+    std::vector<uintptr_t> results;
+    results.reserve(std::min(maxCount, _count));
+
+    for (size_t p = 0; p < _pages.size() && results.size() < maxCount; p++)
+    {
+        const uint64_t *bitmap = _bitmaps.data() + (p * _wordsPerPage);
+        for (size_t w = 0; w < _wordsPerPage && results.size() < maxCount; w++)
+        {
+            uint64_t bits = bitmap[w];
+            while (bits && results.size() < maxCount)
+            {
+                const size_t bit = __builtin_ctzll(bits);
+                bits &= bits - 1;
+                results.push_back(_pages[p] + (((w * 64) + bit) * _alignment));
+            }
+        }
+    }
+
+    return results;
+}
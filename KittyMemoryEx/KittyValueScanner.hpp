@@ -0,0 +1,179 @@
+#pragma once
+
+#include "KittyUtils.hpp"
+#include "KittyMemoryEx.hpp"
+#include "KittyMemOp.hpp"
+#include "KittyScanner.hpp"
+
+#include <type_traits>
+
+enum EKittyValueType
+{
+    EK_VALUE_I8 = 0,
+    EK_VALUE_I16,
+    EK_VALUE_I32,
+    EK_VALUE_I64,
+    EK_VALUE_F32,
+    EK_VALUE_F64
+};
+
+enum EKittyScanCompare
+{
+    // value == a, floats compare with epsilon
+    EK_SCAN_EXACT = 0,
+    // a <= value <= b
+    EK_SCAN_BETWEEN,
+    // value > a
+    EK_SCAN_GREATER,
+    // value < a
+    EK_SCAN_LESS,
+    // first scan only, keeps every slot
+    EK_SCAN_UNKNOWN,
+    // next scan only, compared to previous value
+    EK_SCAN_CHANGED,
+    EK_SCAN_UNCHANGED,
+    EK_SCAN_INCREASED,
+    EK_SCAN_DECREASED,
+    // value == previous + a / value == previous - a
+    EK_SCAN_INCREASED_BY,
+    EK_SCAN_DECREASED_BY
+};
+
+// compare operands, converted once for integer & float types
+struct KittyValueQuery
+{
+    EKittyScanCompare compare;
+    int64_t i1, i2;
+    double f1, f2;
+    double epsilon;
+};
+
+/**
+ * First scan / next scan value search over remote maps.
+ *
+ * Candidates are kept per page as a slot bitmap plus their previous values packed in address order,
+ * so memory use is about one value per hit, next scans only re-read candidate pages using batched reads.
+ * Values crossing a page end are not scanned.
+ */
+class KittyValueScanner
+{
+private:
+    IKittyMemOp *_pMem;
+    EKittyValueType _type;
+    size_t _valueSize, _alignment;
+    double _epsilon;
+    std::shared_ptr<KittyThreadPool> _threadPool;
+
+    size_t _pageSize, _slotsPerPage, _wordsPerPage;
+
+    // candidate pages, wordsPerPage bitmap words per page & packed previous values
+    std::vector<uintptr_t> _pages;
+    std::vector<uint64_t> _bitmaps;
+    std::vector<uint8_t> _values;
+    size_t _count;
+    bool _scanned;
+
+    // integer operand of a, float operands out of int64 range or NaN are left 0 instead of an undefined cast
+    template <typename T>
+    static inline int64_t queryInteger(T a)
+    {
+        if constexpr (std::is_integral<T>::value)
+            return int64_t(a);
+        else
+            return (a >= T(-9223372036854775808.0) && a < T(9223372036854775808.0)) ? int64_t(a) : 0;
+    }
+
+    template <typename T>
+    KittyValueQuery makeQuery(EKittyScanCompare compare, T a, T b) const
+    {
+        KittyValueQuery query{};
+        query.compare = compare;
+        query.i1 = queryInteger(a), query.i2 = queryInteger(b);
+        query.f1 = double(a), query.f2 = double(b);
+        query.epsilon = _epsilon;
+        return query;
+    }
+
+    bool firstScanImpl(const KittyMapFilter &filter, const KittyValueQuery &query);
+    bool nextScanImpl(const KittyValueQuery &query);
+
+public:
+    KittyValueScanner() : _pMem(nullptr), _type(EK_VALUE_I32), _valueSize(4), _alignment(4), _epsilon(0),
+                          _pageSize(0), _slotsPerPage(0), _wordsPerPage(0), _count(0), _scanned(false) {}
+
+    /**
+     * @param type: scanned value type
+     * @param alignment: slot alignment, 0 for value size
+     */
+    KittyValueScanner(IKittyMemOp *pMem, EKittyValueType type, size_t alignment = 0);
+
+    inline EKittyValueType valueType() const { return _type; }
+
+    inline size_t valueSize() const { return _valueSize; }
+
+    /**
+     * Tolerance used by float EXACT, UNCHANGED, CHANGED & INCREASED_BY / DECREASED_BY compares
+     */
+    inline void setEpsilon(double epsilon) { _epsilon = epsilon; }
+
+    /**
+     * Worker pool used by first scan, first scan is done on the calling thread if not set
+     */
+    inline void setThreadPool(std::shared_ptr<KittyThreadPool> pool) { _threadPool = std::move(pool); }
+
+    /**
+     * Scan all maps matching filter, drops any previous results
+     *
+     * @param filter: selects scanned maps, readable & writable by default
+     * @param compare: EXACT, BETWEEN, GREATER, LESS or UNKNOWN
+     */
+    template <typename T>
+    bool firstScan(const KittyMapFilter &filter, EKittyScanCompare compare, T a = T(), T b = T())
+    {
+        return firstScanImpl(filter, makeQuery(compare, a, b));
+    }
+
+    template <typename T>
+    bool firstScan(EKittyScanCompare compare, T a = T(), T b = T())
+    {
+        return firstScanImpl(KittyMapFilter(PROT_READ | PROT_WRITE), makeQuery(compare, a, b));
+    }
+
+    inline bool firstScan(const KittyMapFilter &filter, EKittyScanCompare compare) { return firstScan<int64_t>(filter, compare); }
+
+    inline bool firstScan(EKittyScanCompare compare) { return firstScan<int64_t>(compare); }
+
+    /**
+     * Re-read current candidates and keep those matching compare, candidates that can't be read are dropped.
+     * A batched read failing outright (e.g. process paused or access denied) keeps candidates of its pages
+     * with their previous values & returns false
+     */
+    template <typename T>
+    bool nextScan(EKittyScanCompare compare, T a = T(), T b = T())
+    {
+        return nextScanImpl(makeQuery(compare, a, b));
+    }
+
+    inline bool nextScan(EKittyScanCompare compare) { return nextScan<int64_t>(compare); }
+
+    /**
+     * Number of current candidates
+     */
+    inline size_t count() const { return _count; }
+
+    /**
+     * Current candidates addresses ordered by address
+     * @param maxCount: max results returned
+     */
+    std::vector<uintptr_t> getResults(size_t maxCount = SIZE_MAX) const;
+
+    /**
+     * Memory used to store candidates in bytes
+     */
+    inline size_t memoryUsage() const
+    {
+        return (_pages.capacity() * sizeof(uintptr_t)) + (_bitmaps.capacity() * sizeof(uint64_t)) + _values.capacity();
+    }
+
+    void reset();
+};
@@ -40,12 +40,27 @@ int main(int argc, char *args[])
     
     ElfBaseMap g_il2cppBaseMap;
     // loop until our target library is found
-    do
+    // map watcher reports maps changes so elf base is only looked up again when a map of it changes,
+    // any change is used as the loader maps the file first then mprotects its segments
+    KittyMapWatcher mapWatcher(processID);
+    std::vector<KittyMapChange> mapChanges;
+    g_il2cppBaseMap = kittyMemMgr.getElfBaseMap("libil2cpp.so");
+    while (!g_il2cppBaseMap.isValid())
     {
         sleep(1);
-        // get loaded elf base map
-        g_il2cppBaseMap = kittyMemMgr.getElfBaseMap("libil2cpp.so");
-    } while (!g_il2cppBaseMap.isValid());
+        if (!mapWatcher.poll(mapChanges))
+            continue;
+
+        for (auto &it : mapChanges)
+        {
+            if (it.map.pathname.find("libil2cpp.so") != std::string::npos)
+            {
+                // get loaded elf base map
+                g_il2cppBaseMap = kittyMemMgr.getElfBaseMap("libil2cpp.so");
+                break;
+            }
+        }
+    }
     
     uintptr_t il2cppBase = g_il2cppBaseMap.map.startAddress;
     KITTY_LOGI("libil2cpp.so base: %p", (void *)il2cppBase);
@@ -155,6 +170,15 @@ int main(int argc, char *args[])
     found_at_list = kittyMemMgr.memScanner.findHexAll(search_start, search_end, "33 44 55 66 00 77 88 00 99", "xxxx??x?x");
     KITTY_LOGI("found hex results: %zu", found_at_list.size());
 
+    // scan with IDA style pattern, parse it once and reuse it for every scan
+    KittyPattern ida_pattern = KittyPattern::fromIDA("33 44 55 66 ?? ?? 88 ? 99");
+    found_at = kittyMemMgr.memScanner.findPatternFirst(search_start, search_end, ida_pattern);
+    KITTY_LOGI("found pattern at: %p", (void *)found_at);
+    // or parse it at compile time
+    constexpr KittyPatternLiteral ida_literal("33 44 55 66 ?? ?? 88 ? 99");
+    found_at_list = kittyMemMgr.memScanner.findPatternAll(search_start, search_end, ida_literal);
+    KITTY_LOGI("found pattern results: %zu", found_at_list.size());
+
     // scan with data type & get one result
     uint32_t data = 0xdeadbeef;
     found_at = kittyMemMgr.memScanner.findDataFirst(search_start, search_end, &data, sizeof(data));